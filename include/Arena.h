@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace ATC {
+
+enum ArenaKind {
+    AST_ARENA,      // the ast of a compilation unit
+    IR_ARENA,       // the ir of a compilation unit
+    MACHINE_ARENA,  // the machine code of a function
+    ARENA_KIND_NUM
+};
+
+// a bump pointer allocator, all the objects are destroyed and their memory is released together with the arena
+class Arena {
+public:
+    typedef void (*Destructor)(void*);
+
+    Arena(size_t chunkSize = 64 * 1024) : _chunkSize(chunkSize) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() {
+        // in the reverse order of allocation
+        for (auto iter = _destructors.rbegin(); iter != _destructors.rend(); iter++) {
+            iter->second(iter->first);
+        }
+        for (auto chunk : _chunks) {
+            free(chunk);
+        }
+    }
+
+    // the destructor is called with the returned pointer when the arena is destroyed
+    void* allocate(size_t size, Destructor destructor = nullptr) {
+        size = (size + Align - 1) & ~(Align - 1);
+        if (size > (size_t)(_end - _cur)) {
+            size_t chunkSize = std::max(size, _chunkSize);
+            _cur = static_cast<char*>(malloc(chunkSize));
+            if (_cur == nullptr) {
+                throw std::bad_alloc();
+            }
+            _end = _cur + chunkSize;
+            _chunks.push_back(_cur);
+            _allocatedSize += chunkSize;
+        }
+        void* ret = _cur;
+        _cur += size;
+        if (destructor) {
+            addDestructor(ret, destructor);
+        }
+        return ret;
+    }
+
+    // run a cleanup for the object that isn't in the arena but has the same lifetime
+    void addDestructor(void* ptr, Destructor destructor) { _destructors.push_back({ptr, destructor}); }
+
+    size_t getAllocatedSize() { return _allocatedSize; }
+
+    static Arena* getCurrent(ArenaKind kind) { return Currents[kind]; }
+
+    static void setCurrent(ArenaKind kind, Arena* arena) { Currents[kind] = arena; }
+
+private:
+    static constexpr size_t Align = alignof(max_align_t);
+    static inline Arena* Currents[ARENA_KIND_NUM] = {};
+
+    size_t _chunkSize;
+    size_t _allocatedSize = 0;
+    char* _cur = nullptr;
+    char* _end = nullptr;
+    std::vector<char*> _chunks;
+    std::vector<std::pair<void*, Destructor>> _destructors;
+};
+
+// make the arena current for the kind until the end of the scope
+class ArenaScope {
+public:
+    ArenaScope(ArenaKind kind, Arena* arena) : _kind(kind), _saved(Arena::getCurrent(kind)) {
+        Arena::setCurrent(kind, arena);
+    }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    ~ArenaScope() { Arena::setCurrent(_kind, _saved); }
+
+private:
+    ArenaKind _kind;
+    Arena* _saved;
+};
+
+// the classes derived from it are allocated by new from the current arena of the kind, or from the heap if there is
+// no current arena. the arena destroys them by the destructor of Base, it must be virtual if Base has derived classes
+template <ArenaKind Kind, typename Base>
+class ArenaObject {
+public:
+    static void* operator new(size_t size) {
+        Arena* arena = Arena::getCurrent(Kind);
+        if (arena == nullptr) {
+            return ::operator new(size);
+        }
+        return arena->allocate(size, [](void* ptr) { static_cast<Base*>(ptr)->~Base(); });
+    }
+
+    // the objects are never deleted one by one, the ones in the heap live until the end of process
+    static void operator delete(void*) {}
+};
+
+}  // namespace ATC
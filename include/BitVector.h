@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace ATC {
+
+// a fixed size set of the dense numbers in [0, size)
+class BitVector {
+public:
+    BitVector(int size = 0) : _size(size), _words((size + 63) / 64, 0) {}
+
+    int size() const { return _size; }
+
+    void set(int index) { _words[index / 64] |= (uint64_t)1 << (index % 64); }
+
+    void reset(int index) { _words[index / 64] &= ~((uint64_t)1 << (index % 64)); }
+
+    bool test(int index) const { return _words[index / 64] & ((uint64_t)1 << (index % 64)); }
+
+    BitVector& operator|=(const BitVector& other) {
+        for (std::size_t i = 0; i < _words.size(); i++) {
+            _words[i] |= other._words[i];
+        }
+        return *this;
+    }
+
+    // remove the bits set in other
+    BitVector& operator-=(const BitVector& other) {
+        for (std::size_t i = 0; i < _words.size(); i++) {
+            _words[i] &= ~other._words[i];
+        }
+        return *this;
+    }
+
+    bool operator==(const BitVector& other) const { return _words == other._words; }
+
+    bool operator!=(const BitVector& other) const { return _words != other._words; }
+
+    // call func with every set index in ascending order
+    template <typename Func>
+    void forEach(Func func) const {
+        for (std::size_t i = 0; i < _words.size(); i++) {
+            for (uint64_t word = _words[i]; word != 0; word &= word - 1) {
+                func((int)(i * 64 + __builtin_ctzll(word)));
+            }
+        }
+    }
+
+private:
+    int _size;
+    std::vector<uint64_t> _words;
+};
+
+}  // namespace ATC
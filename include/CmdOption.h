@@ -5,6 +5,17 @@
 #include "llvm/Support/CommandLine.h"
 
 namespace ATC {
+// only -O0, -O1 and -O2 are accepted
+class OptLevelParser : public llvm::cl::parser<unsigned> {
+public:
+    OptLevelParser(llvm::cl::Option& option) : llvm::cl::parser<unsigned>(option) {}
+
+    bool parse(llvm::cl::Option& option, llvm::StringRef argName, llvm::StringRef arg, unsigned& value);
+};
+
+enum RegAllocKind { DEFAULT_REG_ALLOC, GRAPH_REG_ALLOC, LINEAR_REG_ALLOC };
+enum CpuKind { DEFAULT_CPU, U74_CPU, GENERIC_CPU, NO_CPU };
+
 extern llvm::cl::OptionCategory MyCategory;
 extern llvm::cl::list<std::string> SrcPathList;
 extern llvm::cl::opt<bool> Sy;
@@ -17,5 +28,14 @@ extern llvm::cl::opt<std::string> Platform;
 extern llvm::cl::opt<std::string> RunInput;
 extern llvm::cl::opt<bool> Check;
 extern llvm::cl::opt<std::string> CompareFile;
+extern llvm::cl::opt<unsigned, false, OptLevelParser> OptLevel;
+extern llvm::cl::opt<unsigned> UnrollFactor;
+extern llvm::cl::opt<unsigned> UnrollBudget;
+extern llvm::cl::opt<RegAllocKind> RegAlloc;
+extern llvm::cl::opt<bool> PeepholeStats;
+extern llvm::cl::opt<CpuKind> Mcpu;
+extern bool& TimePasses;
+
+void initSharedOptions();
 
 }  // namespace ATC
\ No newline at end of file
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "BitVector.h"
+
+namespace ATC {
+
+// the backward dataflow over the blocks of a function, such as liveness. out is the union of in of the successors, and
+// in = gen | (out - kill), or computed by the transfer function if the problem isn't in the gen/kill form. it works
+// on both IR::BasicBlock and RISCV::BasicBlock
+template <typename BasicBlockT>
+class BackwardDataFlow {
+public:
+    // modify out to in, the transfer must be monotone
+    using TransferFunc = std::function<void(int index, BitVector& value)>;
+
+    // the blocks should be in reverse post order, the worklist visits them backward so most of them are visited after
+    // their successors. the successors out of the blocks are ignored
+    BackwardDataFlow(const std::vector<BasicBlockT*>& blocks, int width)
+        : _blocks(blocks), _width(width), _gens(blocks.size()), _kills(blocks.size()),
+          _ins(blocks.size(), BitVector(width)), _outs(blocks.size(), BitVector(width)) {
+        for (size_t i = 0; i < blocks.size(); i++) {
+            _bb2index[blocks[i]] = i;
+        }
+    }
+
+    void setGenKill(int index, BitVector gen, BitVector kill) {
+        _gens[index] = std::move(gen);
+        _kills[index] = std::move(kill);
+    }
+
+    void setTransfer(TransferFunc transfer) { _transfer = std::move(transfer); }
+
+    void solve() {
+        std::set<int> worklist;
+        for (size_t i = 0; i < _blocks.size(); i++) {
+            worklist.insert(i);
+        }
+        while (!worklist.empty()) {
+            int index = *worklist.rbegin();
+            worklist.erase(index);
+
+            BitVector out(_width);
+            for (auto succ : _blocks[index]->getSuccessors()) {
+                auto iter = _bb2index.find(succ);
+                if (iter != _bb2index.end()) {
+                    out |= _ins[iter->second];
+                }
+            }
+            BitVector in = out;
+            _outs[index] = std::move(out);
+            if (_transfer) {
+                _transfer(index, in);
+            } else {
+                in -= _kills[index];
+                in |= _gens[index];
+            }
+            if (in == _ins[index]) {
+                continue;
+            }
+            _ins[index] = std::move(in);
+            for (auto pred : _blocks[index]->getPredecessors()) {
+                auto iter = _bb2index.find(pred);
+                if (iter != _bb2index.end()) {
+                    worklist.insert(iter->second);
+                }
+            }
+        }
+    }
+
+    const BitVector& getIn(int index) { return _ins[index]; }
+
+    const BitVector& getOut(int index) { return _outs[index]; }
+
+private:
+    std::vector<BasicBlockT*> _blocks;
+    std::unordered_map<BasicBlockT*, int> _bb2index;
+    int _width;
+    TransferFunc _transfer;
+    std::vector<BitVector> _gens;
+    std::vector<BitVector> _kills;
+    std::vector<BitVector> _ins;
+    std::vector<BitVector> _outs;
+};
+
+}  // namespace ATC
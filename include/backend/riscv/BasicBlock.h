@@ -9,7 +9,7 @@ namespace RISCV {
 
 class Function;
 
-class BasicBlock {
+class BasicBlock : public ArenaObject<MACHINE_ARENA, BasicBlock> {
 public:
     BasicBlock(const std::string &name = "");
 
@@ -19,16 +19,22 @@ public:
     void addInstruction(Instruction *inst);
     void addPredecessor(BasicBlock *bb) { _predecessors.push_back(bb); }
     void addSuccessor(BasicBlock *bb) { _successors.push_back(bb); }
-    void setAlives(const std::set<Register *> &alives) { _alives = alives; }
+    void setLoopDepth(int depth) { _loopDepth = depth; }
+    void setIsLoopHeader(bool b) { _loopHeader = b; }
 
     const std::list<Instruction *> &getInstructionList() { return _instructions; }
     std::list<Instruction *> &getMutableInstructionList() { return _instructions; }
     const std::vector<BasicBlock *> &getPredecessors() { return _predecessors; }
     const std::vector<BasicBlock *> &getSuccessors() { return _successors; }
-    const std::set<Register *> &getAlives() { return _alives; }
+    // 0 if the block is not in any loop
+    int getLoopDepth() { return _loopDepth; }
 
     std::string toString() {
         std::string str;
+        // the loop header starts at the fetch boundary
+        if (_loopHeader) {
+            str.append("\t.p2align\t3\n");
+        }
         if (_needLabel) {
             str.append(_name + ":\n");
         }
@@ -38,8 +44,6 @@ public:
         return str;
     }
 
-    void reset() { _alives.clear(); }
-
     // for debug
     void dump();
 
@@ -50,7 +54,8 @@ private:
     std::list<Instruction *> _instructions;
     std::vector<BasicBlock *> _predecessors;
     std::vector<BasicBlock *> _successors;
-    std::set<Register *> _alives;
+    int _loopDepth = 0;
+    bool _loopHeader = false;
 };
 
 }  // namespace RISCV
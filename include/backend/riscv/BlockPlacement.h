@@ -0,0 +1,42 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "Function.h"
+
+namespace ATC {
+
+namespace RISCV {
+
+// reorder the blocks so the hot successor falls through, by Pettis-Hansen chain formation. the edges are weighted by
+// the loop depth, the chains are merged from the heaviest edge and the cond jumps are inverted to fall through
+class BlockPlacement {
+public:
+    BlockPlacement(Function* function) : _theFunction(function) {}
+
+    void run();
+
+private:
+    struct Edge {
+        BasicBlock* _from;
+        BasicBlock* _to;
+        long long _weight;
+    };
+
+    // the block ends without a jump, so its next block must stay after it
+    static bool isFallThrough(BasicBlock* bb);
+
+    void mergeChain(BasicBlock* from, BasicBlock* to);
+
+    // make the cond jump fall through to the next block
+    static void fixTerminator(BasicBlock* bb, BasicBlock* next);
+
+private:
+    Function* _theFunction;
+    std::vector<std::vector<BasicBlock*>> _chains;
+    std::unordered_map<BasicBlock*, int> _bb2chain;
+};
+
+}  // namespace RISCV
+}  // namespace ATC
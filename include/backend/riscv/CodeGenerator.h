@@ -52,8 +52,26 @@ public:
     void emitCondJumpInst(IR::CondJumpInst *);
 
 private:
+    void emitParams(IR::Function *);
+
+    void emitEpilogue(IR::Function *, BasicBlock *);
+
+    // ptr plus the scaled variable index of the gep
+    Register *emitGEPIndex(IR::GetElementPtrInst *, Register *ptr);
+
+    // the ret following the call if it can be a tail call, otherwise nullptr
+    IR::ReturnInst *getTailCallRet(IR::FunctionCallInst *);
+
+    void emitPhiCopies(IR::BasicBlock *from, IR::BasicBlock *to);
+
     Register *emitIntBinaryInst(int instType, IR::Value *operand1, IR::Value *operand2);
 
+    // replace divw and remw by the shifts and the multiplication of magic number
+    Register *emitDivByConst(Register *dividend, int divisor, bool isMod);
+
+    // the magic number and shift of signed division by divisor >= 2 (Hacker's Delight 10-4)
+    static void getDivMagic(int divisor, int &magic, int &shift);
+
     Register *emitFloatBinaryInst(int instType, IR::Value *operand1, IR::Value *operand2);
 
     Register *loadConstInt(int value);
@@ -64,16 +82,25 @@ private:
 
     Register *getRegFromValue(IR::Value *);
 
+    // the compare is only used by the cond jump ending the block, they are emitted as one branch
+    bool isFusedCompare(IR::BinaryInst *);
+
+    // the pointer is only used as the address of load, store, gep and bitcast, so its offset can be folded into them
+    bool isAddressOnly(IR::Value *);
+
     Register *processIfImmOutOfRange(Register *src, int &offset);
 
 private:
     Function *_currentFunction;
     BasicBlock *_currentBasicBlock;
+    IR::BasicBlock *_currentIRBasicBlock;
     BasicBlock *_entryBB;
     BasicBlock *_retBB;
 
     int _offset = 0;                                         // record current offset of sp
     std::unordered_map<IR::Value *, int> _value2offset;  // offset of sp
+    std::set<IR::Value *> _fusedCompares;  // the compare results never materialized
+    std::set<IR::Value *> _foldedAddrs;  // the pointers are the reg plus the offset, folded into the imm of their users
 
     std::unordered_map<IR::Value *, Register *> _value2reg;  // IR value to asm reg
 
@@ -86,6 +113,9 @@ private:
     std::stringstream _contend;
 
     int _maxPassParamsStackOffset = 0;  // pass the function params
+
+    std::vector<BasicBlock *> _tailCallBBs;     // the blocks ending with a tail call
+    std::set<IR::Instruction *> _tailCallRets;  // the rets replaced by tail calls
 };
 
 }  // namespace RISCV
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "Function.h"
+
+namespace ATC {
+
+namespace RISCV {
+
+// the pipeline of an in-order core, the latency is the cycles from the issue of an instruction to the issue of its
+// users. at most one instruction per cycle goes to each of the memory, the multiplier and the fpu
+struct SchedModel {
+    enum { ALU, LOAD, STORE, MUL, DIV, FP, FDIV, FP_CVT, FP_MV, CLASS_NUM };
+    enum { NO_UNIT, MEM_UNIT, MUL_UNIT, FP_UNIT, UNIT_NUM };
+
+    const char* _name;
+    int _issueWidth;
+    int _latencies[CLASS_NUM];
+
+    static int getUnit(int instClass);
+
+    // nullptr if there is no such cpu
+    static const SchedModel* get(const std::string& name);
+};
+
+// list scheduling in the regions between the calls and the jumps of a block, the instruction on the longest latency
+// path is issued first. before the register allocation an instruction is moved up by at most PreAllocWindow
+// instructions, so the register pressure doesn't grow too much
+class InstScheduler {
+public:
+    InstScheduler(Function* function, const SchedModel* model, bool isAllocated)
+        : _theFunction(function), _model(model), _isAllocated(isAllocated) {}
+
+    void run();
+
+private:
+    using InstIter = std::list<Instruction*>::iterator;
+
+    struct Node {
+        Instruction* _inst;
+        int _class;
+        std::vector<std::pair<int, int>> _succs;  // the node and the latency
+        int _predNum = 0;
+        int _height = 0;
+        int _earliest = 0;  // the earliest cycle to issue
+        // the accessed memory, the base reg is identified by its name and the number of its defs before
+        std::string _base;
+        int _baseVersion = 0;
+        int _offset = 0;
+        int _width = 0;
+    };
+
+    void scheduleRegion(InstIter begin, InstIter end);
+    void buildDependences();
+    void addDependence(int from, int to, int latency);
+    bool mayAlias(const Node& a, const Node& b);
+
+    // the calls, the jumps and the ret are never moved
+    static bool isBarrier(Instruction* inst);
+    static int getInstClass(Instruction* inst);
+    static int getAccessWidth(Instruction* inst);
+
+    static const int PreAllocWindow = 8;
+
+private:
+    Function* _theFunction;
+    const SchedModel* _model;
+    bool _isAllocated;
+    std::vector<Node> _nodes;
+};
+
+}  // namespace RISCV
+}  // namespace ATC
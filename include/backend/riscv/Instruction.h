@@ -20,14 +20,22 @@ enum InstId {
     ID_COND_JUMP_INST
 };
 
-class Instruction {
+class Instruction : public ArenaObject<MACHINE_ARENA, Instruction> {
 public:
+    virtual ~Instruction() = default;
+
     virtual int getClassId() = 0;
 
     virtual std::string toString() = 0;
 
     void setImm(int imm) { _imm = imm; }
 
+    void setDest(Register* reg) { _dest = reg; }
+
+    void setSrc1(Register* reg) { _src1 = reg; }
+
+    void setSrc2(Register* reg) { _src2 = reg; }
+
     int getInstType() { return _type; }
 
     Register* getDest() { return _dest; }
@@ -122,18 +130,25 @@ public:
 
 class FunctionCallInst : public Instruction {
 public:
-    FunctionCallInst(const std::string& funcName, Register* dest) : _funcName(funcName) { _dest = dest; }
+    // a tail call jumps to the callee after the frame is released, the callee returns to our caller directly
+    FunctionCallInst(const std::string& funcName, Register* dest, bool isTail = false)
+        : _funcName(funcName), _isTail(isTail) {
+        _dest = dest;
+    }
 
     virtual int getClassId() override { return ID_FUNCTION_CALL_INST; }
 
-    virtual std::string toString() override { return "call\t" + _funcName; }
+    virtual std::string toString() override { return (_isTail ? "tail\t" : "call\t") + _funcName; }
 
     void addUsedReg(Register* reg) { _usedRegs.insert(reg); }
 
     const std::set<Register*> getUsedRges() { return _usedRegs; }
 
+    bool isTail() { return _isTail; }
+
 private:
     std::string _funcName;
+    bool _isTail;
     std::set<Register*> _usedRegs;
 };
 
@@ -223,8 +238,12 @@ public:
         INST_SLTI,
         INST_XORI,
         INST_SLLI,
+        INST_SRAI,
 
         INST_ADDIW,
+        INST_SLLIW,
+        INST_SRAIW,
+        INST_SRLIW,
 
         INST_ADD,
         INST_SUB,
@@ -256,6 +275,9 @@ public:
 
     BasicBlock* getTargetBB() { return _targetBB; }
 
+    // the predecessors and successors aren't updated
+    void setTargetBB(BasicBlock* bb) { _targetBB = bb; }
+
     virtual int getClassId() override { return ID_JUMP_INST; }
 
     virtual std::string toString() override;
@@ -274,6 +296,8 @@ public:
 
     virtual int getClassId() override { return ID_COND_JUMP_INST; }
 
+    void setInstType(int type) { _type = type; }
+
     virtual std::string toString() override;
 
     enum { INST_BEQ, INST_BNE, INST_BLT, INST_BGE };
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace ATC {
+
+namespace RISCV {
+
+// the nodes [0, precoloredNum) are the phy regs and the others are the virtual regs. the edges are kept in a
+// triangular bit matrix for O(1) query and in the adjacency lists for visiting the neighbours. the precolored nodes
+// have no adjacency lists and never interfere with each other
+class InterferenceGraph {
+public:
+    InterferenceGraph(int size = 0, int precoloredNum = 0);
+
+    void addEdge(int a, int b);
+
+    bool hasEdge(int a, int b) const;
+
+    // move the edges of from to to, from is left without any edge
+    void merge(int from, int to);
+
+    const std::vector<int>& getNeighbours(int node) { return _adjLists[node]; }
+
+    int getDegree(int node) { return _adjLists[node].size(); }
+
+    int size() { return _size; }
+
+    bool isPrecolored(int node) { return node < _precoloredNum; }
+
+private:
+    static std::size_t getBitIndex(int a, int b);
+
+    void removeEdge(int a, int b);
+
+private:
+    int _size;
+    int _precoloredNum;
+    std::vector<uint64_t> _matrix;
+    std::vector<std::vector<int>> _adjLists;
+};
+
+}  // namespace RISCV
+
+}  // namespace ATC
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <iostream>
+#include <list>
+#include <unordered_map>
+
+#include "Function.h"
+
+namespace ATC {
+
+namespace RISCV {
+
+// local rewrites by a table of rules, a rule looks at the window starting from the current instruction of a block.
+// it runs before the register allocation on the virtual regs and after it on the phy regs
+class PeepholeOptimizer {
+public:
+    PeepholeOptimizer(Function* function, bool isAllocated) : _theFunction(function), _isAllocated(isAllocated) {}
+
+    // return true if any instruction is changed
+    bool run();
+
+    // the hit count of every rule since the last printing
+    static void printStatistics(std::ostream& os);
+
+private:
+    using InstIter = std::list<Instruction*>::iterator;
+    // a rule changes the window in place and returns true if it matches. iter points to the instruction replacing the
+    // current one, or the next one if the current one is erased
+    using RuleFunc = bool (PeepholeOptimizer::*)(std::list<Instruction*>& instList, InstIter& iter);
+
+    struct Rule {
+        const char* _name;
+        RuleFunc _func;
+        bool _beforeAlloc;
+        bool _afterAlloc;
+        int _hits;
+    };
+
+    static std::vector<Rule> Rules;
+    static const int MaxChainLength = 8;
+
+    bool removeSelfMove(std::list<Instruction*>& instList, InstIter& iter);
+    bool zeroImmToMove(std::list<Instruction*>& instList, InstIter& iter);
+    bool forwardStoreToLoad(std::list<Instruction*>& instList, InstIter& iter);
+    bool useZeroReg(std::list<Instruction*>& instList, InstIter& iter);
+    bool foldBoolChain(std::list<Instruction*>& instList, InstIter& iter);
+    bool removeDeadDef(std::list<Instruction*>& instList, InstIter& iter);
+
+    // the uses and the defs of the virtual regs, only before the register allocation
+    void buildDefUse();
+    void addUses(Instruction* inst, int delta);
+    void replaceInst(InstIter& iter, Instruction* inst);
+    void eraseInst(std::list<Instruction*>& instList, InstIter& iter);
+    void replaceSrc(Instruction* inst, Register* from, Register* to);
+
+    // the only def of the virtual reg, otherwise nullptr
+    Instruction* getDef(Register* reg);
+    // the src of the mv chain defining the reg
+    Register* getCopySource(Register* reg);
+    // the reg is 0 or 1
+    bool isBool(Register* reg, int depth = 0);
+
+    static bool isMove(Instruction* inst);
+
+private:
+    Function* _theFunction;
+    bool _isAllocated;
+    std::unordered_map<Register*, int> _useCount;
+    std::unordered_map<Register*, Instruction*> _defs;  // nullptr if the reg is defined more than once
+};
+
+}  // namespace RISCV
+}  // namespace ATC
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <unordered_map>
+
+#include "../BitVector.h"
 #include "Function.h"
+#include "InterferenceGraph.h"
 
 namespace ATC {
 
@@ -15,17 +19,51 @@ public:
 
 private:
     void buildInterference();
+    // merge the regs of mv and fmv.s if the graph is still colorable, conservative as Briggs and George
     void coalescing();
     bool coloring();
     void spill();
+    void spillOneReg(Register* needSpill);
+
+    // number the regs densely and compute the regs alive out of every block
+    void buildLiveness();
+
+    // linear scan, the instructions are numbered in the order of the blocks, a use is at 2 * n and a def is at 2 * n + 1
+    void buildIntervals();
+    bool linearScan();
+
+    // the node of reg in the interference graph, -1 if it can't be allocated
+    int getNode(Register* reg);
+    bool isIntNode(int node);
+
+    // the id is the position in the list of the phy regs
+    void setPhyReg(Register* reg, int id);
 
     void reset();
 
 private:
+    struct Interval {
+        Register* _reg;
+        int _start;
+        int _end;
+    };
+
     Function* _theFunction;
     int& _currentOffset;  // for spill reg
     bool _useGraphColoring;
-    Register* _needSpill = nullptr;
+    std::vector<Register*> _needSpills;  // the regs failed to color in this round
+
+    std::vector<Register*> _regs;  // the dense number to reg
+    std::unordered_map<Register*, int> _reg2index;
+    std::unordered_map<BasicBlock*, BitVector> _liveOuts;
+
+    InterferenceGraph _graph;
+    std::vector<int> _reg2node;        // the dense number of reg to its node
+    std::vector<Register*> _nodeRegs;  // the node to reg, the phy node keeps any fixed reg of it
+    std::vector<int> _aliases;         // the coalesced node to the node it's merged into, -1 if not coalesced
+
+    std::vector<Interval> _intervals;                          // the virtual regs, without lifetime holes
+    std::vector<std::vector<std::pair<int, int>>> _fixedRanges;  // the ranges occupied by every phy reg
 };
 }  // namespace RISCV
-}  // namespace ATC
\ No newline at end of file
+}  // namespace ATC
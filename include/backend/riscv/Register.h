@@ -2,22 +2,22 @@
 
 #include <set>
 #include <string>
+
+#include "../Arena.h"
 namespace ATC {
 namespace RISCV {
 
 class Instruction;
-class Register {
+class Register : public ArenaObject<MACHINE_ARENA, Register> {
 public:
     Register(bool b = true);
 
     void setName(const std::string &name) { _name = name; }
-    void addInterference(Register *reg) { _interferences.insert(reg); }
     void setIsFixed(bool b) { _fixed = b; }
     void setSpillOffset(int offset) { _spillOffset = offset; }
     void setSpilled() { _spilled = true; }
 
     const std::string &getName() { return _name; }
-    const std::set<Register *> &getInterferences() { return _interferences; }
     bool isIntReg() { return _intReg; }
     bool isFixed() { return _fixed; }
     int getSpillOffset() { return _spillOffset; }
@@ -36,7 +36,6 @@ public:
 private:
     static int Index;
     std::string _name;
-    std::set<Register *> _interferences;
     bool _intReg;
     bool _fixed = false;
     int _spillOffset;
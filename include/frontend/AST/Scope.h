@@ -8,7 +8,7 @@
 
 namespace ATC {
 
-class Scope {
+class Scope : public ArenaObject<AST_ARENA, Scope> {
 public:
     Scope() = default;
 
@@ -2,6 +2,7 @@
 
 #include <string>
 
+#include "../Arena.h"
 #include "ASTVisitor.h"
 #include "antlr4-runtime.h"
 
@@ -54,10 +55,12 @@ typedef struct {
     int _rightColumn = 0;
 } Position;
 
-class TreeNode {
+class TreeNode : public ArenaObject<AST_ARENA, TreeNode> {
 public:
     TreeNode() = default;
 
+    virtual ~TreeNode() = default;
+
     virtual int getClassId() = 0;
 
     std::string getName() { return _name; }
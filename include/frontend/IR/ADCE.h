@@ -0,0 +1,34 @@
+#pragma once
+
+#include <set>
+#include <unordered_map>
+
+#include "Pass.h"
+
+namespace ATC {
+namespace IR {
+
+// mark the instructions which the side effects depend on and erase the others
+class ADCE : public ModulePass {
+public:
+    virtual std::string getName() override { return "adce"; }
+
+    virtual bool runOnModule(Module* module) override;
+
+private:
+    void computeSideEffects(Module* module);
+    bool computeSideEffect(Function* function);
+    void collectDeadAllocas(Function* function);
+    bool isRoot(Instruction* inst);
+    bool runOnFunction(Function* function);
+
+    bool isLocalAddr(Value* addr, Function* function);
+
+private:
+    std::unordered_map<std::string, Function*> _name2function;
+    std::set<Function*> _sideEffectFunctions;
+    std::set<Value*> _deadAllocas;  // local memory which is never read and never escapes
+};
+
+}  // namespace IR
+}  // namespace ATC
@@ -9,23 +9,27 @@ namespace IR {
 
 class Function;
 
-class BasicBlock {
+class BasicBlock : public ArenaObject<IR_ARENA, BasicBlock> {
 public:
     BasicBlock(Function* parent, const std::string& name);
 
-    void addPredecessor(BasicBlock* bb) { _predecessors.push_back(bb); }
-    void addSuccessor(BasicBlock* bb) { _successors.push_back(bb); }
+    void addPredecessor(BasicBlock* bb);
+    void addSuccessor(BasicBlock* bb);
+    void removePredecessor(BasicBlock* bb);
+    void removeSuccessor(BasicBlock* bb);
+    void replacePredecessor(BasicBlock* from, BasicBlock* to);
+    void replaceSuccessor(BasicBlock* from, BasicBlock* to);
     void addInstruction(Instruction* inst);
-    void setAlives(const std::set<Value*>& alives) { _alives = alives; }
     void setHasBr() { _hasBr = true; }
+    void setIndex(int index) { _index = index; }
 
     Function* getParent() { return _parent; }
     const std::string& getName() { return _name; }
     const std::vector<BasicBlock*>& getPredecessors() { return _predecessors; }
     const std::vector<BasicBlock*>& getSuccessors() { return _successors; }
     std::list<Instruction*>& getInstructionList() { return _instructions; }
-    const std::set<Value*>& getAlives() { return _alives; }
     bool isHasBr() { return _hasBr; }
+    int getIndex() { return _index; }
 
     std::string getBBStr();
 
@@ -35,8 +39,8 @@ private:
     std::vector<BasicBlock*> _predecessors;
     std::vector<BasicBlock*> _successors;
     std::list<Instruction*> _instructions;
-    std::set<Value*> _alives;
     bool _hasBr = false;
+    int _index = -1;  // dense number in function, assigned by the cfg analysis
 };
 
 }  // namespace IR
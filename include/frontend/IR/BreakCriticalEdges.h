@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Pass.h"
+
+namespace ATC {
+namespace IR {
+
+// the backend lowers phi to copies at the end of predecessors, which is wrong if the predecessor has other successors,
+// so split every critical edge whose target has phi
+class BreakCriticalEdges : public FunctionPass {
+public:
+    virtual std::string getName() override { return "break-critical-edges"; }
+
+    virtual bool runOnFunction(Function* function) override;
+
+    // insert a new block which only jumps to the "to" block on the edge
+    static BasicBlock* splitEdge(BasicBlock* from, BasicBlock* to);
+};
+
+}  // namespace IR
+}  // namespace ATC
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <set>
+#include <unordered_map>
+
+#include "Module.h"
+
+namespace ATC {
+namespace IR {
+
+// the calls between the functions defined in module, the library functions are not included
+class CallGraph {
+public:
+    CallGraph(Module* module);
+
+    // nullptr if it's a library function
+    Function* getFunction(const std::string& name);
+
+    // the calls to the functions defined in module
+    const std::vector<FunctionCallInst*>& getCallSites(Function* caller) { return _callSites[caller]; }
+
+    const std::set<Function*>& getCallees(Function* caller) { return _callees[caller]; }
+
+    const std::set<Function*>& getCallers(Function* callee) { return _callers[callee]; }
+
+    // the callees come before their callers, except the ones calling each other
+    const std::vector<Function*>& getBottomUpOrder() { return _bottomUpOrder; }
+
+    // it may call itself directly or through other functions
+    bool isRecursive(Function* function) { return _recursiveFunctions.find(function) != _recursiveFunctions.end(); }
+
+private:
+    // tarjan's algorithm, the strongly connected components are found in bottom up order
+    void visit(Function* function);
+
+private:
+    std::unordered_map<std::string, Function*> _name2function;
+    std::unordered_map<Function*, std::vector<FunctionCallInst*>> _callSites;
+    std::unordered_map<Function*, std::set<Function*>> _callees;
+    std::unordered_map<Function*, std::set<Function*>> _callers;
+    std::vector<Function*> _bottomUpOrder;
+    std::set<Function*> _recursiveFunctions;
+
+    int _index = 0;
+    std::unordered_map<Function*, int> _indexes;
+    std::unordered_map<Function*, int> _lowLinks;
+    std::vector<Function*> _stack;
+    std::set<Function*> _onStack;
+};
+
+}  // namespace IR
+}  // namespace ATC
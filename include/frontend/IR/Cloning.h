@@ -0,0 +1,45 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "Function.h"
+
+namespace ATC {
+namespace IR {
+
+// clone the blocks into a function, the operands, jump targets and incoming blocks of the clones are remapped to the
+// cloned values and blocks, the values and blocks which aren't cloned or mapped explicitly are kept
+class Cloner {
+public:
+    Cloner(Function* function) : _function(function) {}
+
+    // map a value before cloning, the instruction defining it won't be cloned
+    void mapValue(Value* from, Value* to) { _valueMap[from] = to; }
+
+    void mapBB(BasicBlock* from, BasicBlock* to) { _bbMap[from] = to; }
+
+    // the mapped one or itself
+    Value* getValue(Value* value);
+
+    BasicBlock* getBB(BasicBlock* bb);
+
+    // the clones are appended to the function in order, the cfg edges are not added
+    std::vector<BasicBlock*> cloneBBs(const std::vector<BasicBlock*>& bbs);
+
+    void remapInstruction(Instruction* inst);
+
+private:
+    Function* _function;
+    std::unordered_map<Value*, Value*> _valueMap;
+    std::unordered_map<BasicBlock*, BasicBlock*> _bbMap;
+};
+
+// add the cfg edges from bb to the targets of its terminator
+void addSuccessorEdges(BasicBlock* bb);
+
+// merge the block into its predecessor if they are both in bbs, and the predecessor jumps to it unconditionally and
+// it has no other predecessor
+void mergeBlocks(const std::vector<BasicBlock*>& bbs);
+
+}  // namespace IR
+}  // namespace ATC
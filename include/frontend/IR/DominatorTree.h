@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+#include "BasicBlock.h"
+
+namespace ATC {
+namespace IR {
+
+// dominator tree or post dominator tree of a function, all the info is stored in flat vectors indexed by the number of
+// block, use Function::getDominatorTree() and Function::getPostDominatorTree() to get the cached one
+class DominatorTree {
+public:
+    DominatorTree(Function* function, bool isPostDom = false);
+
+    bool isPostDom() { return _isPostDom; }
+
+    // false if the block can't be reached from the entry, or can't reach any exit for post dominator tree
+    bool isReachable(BasicBlock* bb) { return _dfsIn[bb->getIndex()] >= 0; }
+
+    // nullptr for the roots and the unreachable blocks
+    BasicBlock* getIdom(BasicBlock* bb);
+
+    // the entry block, or all the exit blocks for post dominator tree
+    const std::vector<BasicBlock*>& getRoots() { return _roots; }
+
+    const std::vector<BasicBlock*>& getChildren(BasicBlock* bb) { return _children[bb->getIndex()]; }
+
+    const std::vector<BasicBlock*>& getDominanceFrontier(BasicBlock* bb) { return _frontiers[bb->getIndex()]; }
+
+    // reachable blocks in the reverse post order of cfg, or reverse cfg for post dominator tree
+    const std::vector<BasicBlock*>& getReversePostOrder() { return _rpo; }
+
+    // every block dominates itself
+    bool dominates(BasicBlock* a, BasicBlock* b);
+
+    bool strictlyDominates(BasicBlock* a, BasicBlock* b) { return a != b && dominates(a, b); }
+
+private:
+    void buildGraph();
+    void computeReversePostOrder();
+    void computeIdom();
+    void computeChildren();
+    void computeFrontiers();
+
+private:
+    Function* _function;
+    bool _isPostDom;
+    int _rootIndex;  // the virtual root which links to all the roots, its index is the number of blocks
+
+    std::vector<BasicBlock*> _blocks;  // block index to block
+    std::vector<BasicBlock*> _roots;
+    std::vector<std::vector<int>> _succs;  // edges of cfg, or reverse cfg for post dominator tree
+    std::vector<std::vector<int>> _preds;
+    std::vector<int> _order;  // reachable indexes in reverse post order, starts with the virtual root
+    std::vector<BasicBlock*> _rpo;
+    std::vector<int> _rpoNumber;  // block index to its position in _order, -1 if unreachable
+    std::vector<int> _idom;       // block index to index of its idom, -1 if unreachable
+    std::vector<std::vector<BasicBlock*>> _children;  // the children of virtual root are not included
+    std::vector<std::vector<BasicBlock*>> _frontiers;
+    std::vector<int> _dfsIn;   // preorder number in dominator tree, for O(1) dominance query
+    std::vector<int> _dfsOut;  // postorder number in dominator tree
+};
+
+}  // namespace IR
+}  // namespace ATC
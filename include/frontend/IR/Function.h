@@ -9,6 +9,8 @@ namespace ATC {
 namespace IR {
 
 class Module;
+class DominatorTree;
+class LoopInfo;
 
 struct FuncTyHash {
     int operator()(const std::pair<Type*, std::vector<Type*>>& funcTy) const {
@@ -41,13 +43,21 @@ private:
     FunctionType() {}
 };
 
-class Function {
+// allocated in the ir arena, the cached analyses are released with it
+class Function : public ArenaObject<IR_ARENA, Function> {
 public:
     Function(Module* parent, const FunctionType& functionType, const std::string& name);
 
+    ~Function() { invalidateCFGAnalysis(); }
+
     void addParam(Value* param) { _params.push_back(param); }
 
-    void insertBB(BasicBlock* bb) { _basicBlocks.push_back(bb); }
+    void insertBB(BasicBlock* bb);
+
+    void removeBB(BasicBlock* bb);
+
+    // remove the blocks can't be reached from entry, return true if any block is removed
+    bool removeUnreachableBB();
 
     void setHasFunctionCall(bool b) { _hasFunctionCall = b; }
 
@@ -63,6 +73,18 @@ public:
 
     const std::vector<BasicBlock*>& getBasicBlocks() { return _basicBlocks; }
 
+    // reverse post order of the blocks reachable from entry
+    std::vector<BasicBlock*> getReversePostOrder();
+
+    // the analyses are computed lazily and cached until the cfg is changed
+    DominatorTree* getDominatorTree();
+
+    DominatorTree* getPostDominatorTree();
+
+    LoopInfo* getLoopInfo();
+
+    void invalidateCFGAnalysis();
+
     bool hasFunctionCall() { return _hasFunctionCall; }
 
     std::string getUniqueNameInFunction(void* ptr);
@@ -93,6 +115,9 @@ private:
     int _valueIndex = 0;
     std::list<Instruction*>::iterator _currentAllocIter;
     bool _isCurAllocIterInit = false;
+    DominatorTree* _domTree = nullptr;
+    DominatorTree* _postDomTree = nullptr;
+    LoopInfo* _loopInfo = nullptr;
 };
 }  // namespace IR
 }  // namespace ATC
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "Pass.h"
+
+namespace ATC {
+namespace IR {
+
+// walk the dominator tree with a scoped hash table, an instruction is replaced by the equivalent one in its dominators.
+// loads are versioned by memory generation which is changed by every store and call
+class GVN : public FunctionPass {
+public:
+    virtual std::string getName() override { return "gvn"; }
+
+    virtual bool runOnFunction(Function* function) override;
+
+    virtual bool preservesCFG() override { return true; }
+
+private:
+    struct Expression {
+        int _classId;
+        int _instType;
+        Type* _type;
+        std::vector<Value*> _operands;
+        int _generation;  // only used by load
+
+        bool operator<(const Expression& other) const;
+    };
+
+    struct ScopeFrame {
+        BasicBlock* _bb;
+        size_t _nextChild;
+        int _generation;                        // the memory generation at the end of the block
+        std::vector<Expression> _insertedExprs;  // erased when leaving the scope
+    };
+
+    bool getExpression(Instruction* inst, Expression& expr);
+    void processBB(ScopeFrame& frame);
+
+private:
+    std::map<Expression, Value*> _expr2value;
+    int _generation;
+    int _maxGeneration;
+    bool _changed;
+};
+
+}  // namespace IR
+}  // namespace ATC
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <set>
+#include <unordered_map>
+
+#include "LoopInfo.h"
+
+namespace ATC {
+namespace IR {
+
+// the phi in loop header which is increased by a constant in every iteration, iv = init + step * iteration
+struct BasicInductionVariable {
+    PhiInst* _phi;
+    Value* _init;            // the incoming from preheader
+    int _step;
+    BinaryInst* _increment;  // the incoming from latch
+};
+
+// scale * iv + sum(coefficient * invariant) + constant
+struct AffineExpression {
+    BasicInductionVariable* _iv = nullptr;
+    int _scale = 0;
+    std::vector<std::pair<Value*, int>> _terms;
+    int _constant = 0;
+};
+
+// find the basic induction variables of a loop and the values which are affine functions of them, the loop should
+// have a preheader and only one latch
+class InductionVariables {
+public:
+    InductionVariables(Loop* loop);
+
+    Loop* getLoop() { return _loop; }
+
+    std::vector<BasicInductionVariable>& getBasicIVs() { return _basicIVs; }
+
+    BasicInductionVariable* getBasicIV(Value* value);
+
+    // defined out of loop
+    bool isInvariant(Value* value);
+
+    // false if the value isn't affine or has no induction variable
+    bool getAffine(Value* value, AffineExpression& expr);
+
+private:
+    bool computeAffine(Value* value, AffineExpression& expr);
+
+private:
+    Loop* _loop;
+    std::set<Instruction*> _loopInsts;
+    std::vector<BasicInductionVariable> _basicIVs;
+    std::unordered_map<Value*, AffineExpression> _affineCache;
+    std::set<Value*> _notAffine;
+};
+
+}  // namespace IR
+}  // namespace ATC
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "CallGraph.h"
+#include "Pass.h"
+
+namespace ATC {
+namespace IR {
+
+// inline the calls in bottom up order of call graph, so the callees have been inlined into before being inlined. the
+// small leaf functions are always inlined, others are inlined if their size minus the benefit is below the threshold.
+// the functions which are never called after inlining are removed if the module is the whole program
+class Inliner : public ModulePass {
+public:
+    virtual std::string getName() override { return "inline"; }
+
+    virtual bool runOnModule(Module* module) override;
+
+private:
+    // find a call which should be inlined and inline it, return false if not found
+    bool inlineOneCall(Function* caller);
+    bool shouldInline(FunctionCallInst* callInst, BasicBlock* bb, Function* caller, Function* callee);
+    void inlineCall(FunctionCallInst* callInst, BasicBlock* bb, Function* caller, Function* callee);
+
+    static int getSize(Function* function);
+    static bool hasCall(Function* function);
+    static bool hasReturn(Function* function);
+
+private:
+    static const int AlwaysInlineSize = 30;  // for the leaf functions
+    static const int InlineThreshold = 60;
+    static const int OnlyCallThreshold = 400;  // the callee is removed after inlining its only call
+    static const int MaxCallerSize = 3000;
+    static const int CallBenefit = 6;  // the call, the saves of return address and frame pointer
+    static const int ConstantArgBenefit = 8;
+
+    CallGraph* _callGraph;
+};
+
+}  // namespace IR
+}  // namespace ATC
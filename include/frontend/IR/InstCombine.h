@@ -0,0 +1,72 @@
+#pragma once
+
+#include <set>
+#include <unordered_map>
+
+#include "Pass.h"
+
+namespace ATC {
+namespace IR {
+
+// algebraic simplification by a table of rewrite rules. the instructions are visited from a worklist, the users of a
+// replaced value and the new instructions are visited again, so the rules are applied until nothing matches
+class InstCombine : public FunctionPass {
+public:
+    virtual std::string getName() override { return "instcombine"; }
+
+    virtual bool runOnFunction(Function* function) override;
+
+    virtual bool preservesCFG() override { return true; }
+
+private:
+    // the binary and unary rules return the value replacing the instruction or nullptr, the cond jump rules change the
+    // cond jump in place and return true if it's changed
+    using BinaryRule = Value* (InstCombine::*)(BinaryInst*);
+    using UnaryRule = Value* (InstCombine::*)(UnaryInst*);
+    using CondJumpRule = bool (InstCombine::*)(CondJumpInst*);
+
+    static const std::vector<BinaryRule> BinaryRules;
+    static const std::vector<UnaryRule> UnaryRules;
+    static const std::vector<CondJumpRule> CondJumpRules;
+
+    bool visit(Instruction* inst);
+
+    Value* foldBinary(BinaryInst* inst);
+    Value* moveConstantRight(BinaryInst* inst);
+    Value* simplifyIdentity(BinaryInst* inst);
+    Value* simplifyNegation(BinaryInst* inst);
+    Value* reassociateConstant(BinaryInst* inst);
+    Value* combineLikeTerms(BinaryInst* inst);
+    Value* simplifyBoolCompare(BinaryInst* inst);
+
+    Value* foldUnary(UnaryInst* inst);
+
+    bool moveConstantRight(CondJumpInst* inst);
+    bool branchOnCompare(CondJumpInst* inst);
+
+    // the new instruction is inserted before pos and visited later
+    Value* insertBefore(Instruction* pos, Instruction* inst);
+    void push(Instruction* inst);
+    void pushUsers(Value* value);
+    void eraseIfDead(Instruction* inst);
+
+    // x for 0 - x, otherwise nullptr
+    static Value* getNegatedOperand(Value* value);
+    // (y, c) for y * c, otherwise (value, 1)
+    static std::pair<Value*, int> getTerm(Value* value);
+
+    static bool isCompare(int type) { return type >= BinaryInst::INST_LT; }
+    static int getSwappedCompare(int type);
+    static int getInvertedCompare(int type);
+    static int toCondJumpType(int type);
+    static int toCompareType(int type);
+
+private:
+    Function* _function;
+    std::unordered_map<Instruction*, BasicBlock*> _inst2bb;
+    std::vector<Instruction*> _worklist;
+    std::set<Instruction*> _inWorklist;
+};
+
+}  // namespace IR
+}  // namespace ATC
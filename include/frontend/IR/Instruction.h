@@ -21,21 +21,47 @@ enum InstId {
     ID_UNARY_INST,
     ID_BINARY_INST,
     ID_JUMP_INST,
-    ID_COND_JUMP_INST
+    ID_COND_JUMP_INST,
+    ID_PHI_INST
 };
 
-class Instruction {
+class Instruction : public ArenaObject<IR_ARENA, Instruction> {
 public:
+    virtual ~Instruction() = default;
+
     virtual int getClassId() = 0;
 
     virtual std::string toString() = 0;
 
+    // a copy with the same operands, its result is unnamed and it isn't inserted into any block
+    virtual Instruction* clone() = 0;
+
     virtual Value* getResult() { return nullptr; }
 
+    std::vector<Value*> getOperands();
+
+    Value* getOperand(int index) { return _operands[index]->get(); }
+
+    void setOperand(int index, Value* value) { _operands[index]->set(value); }
+
+    int getOperandNum() { return _operands.size(); }
+
+    void replaceOperand(Value* from, Value* to);
+
+    // remove this inst from the use lists of its operands, must be called before erasing it from the block
+    void dropAllReferences();
+
     void setIsDead(bool b) { _dead = b; }
 
     bool isDead() { return _dead; }
 
+protected:
+    void addOperand(Value* value) { _operands.push_back(new Use(value, this)); }
+
+    void removeOperand(int index);
+
+    std::vector<Use*> _operands;
+
 private:
     bool _dead = false;
 };
@@ -48,6 +74,8 @@ public:
 
     virtual std::string toString() override;
 
+    virtual Instruction* clone() override;
+
     virtual Value* getResult() override { return _result; }
 
     bool isAllocForParam() { return _allocForParam; }
@@ -69,19 +97,20 @@ private:
 
 class StoreInst : public Instruction {
 public:
-    StoreInst(Value* value, Value* dest) : _value(value), _dest(dest) {}
+    StoreInst(Value* value, Value* dest) {
+        addOperand(value);
+        addOperand(dest);
+    }
 
     virtual int getClassId() override { return ID_STORE_INST; }
 
     virtual std::string toString() override;
 
-    Value* getValue() { return _value; }
+    virtual Instruction* clone() override;
 
-    Value* getDest() { return _dest; }
+    Value* getValue() { return getOperand(0); }
 
-private:
-    Value* _value;
-    Value* _dest;
+    Value* getDest() { return getOperand(1); }
 };
 
 class FunctionCallInst : public Instruction {
@@ -93,15 +122,16 @@ public:
 
     virtual std::string toString() override;
 
+    virtual Instruction* clone() override;
+
     virtual Value* getResult() override { return _result; }
 
     const std::string& getFuncName() { return _funcName; }
 
-    const std::vector<Value*>& getParams() { return _params; }
+    std::vector<Value*> getParams() { return getOperands(); }
 
 private:
     std::string _funcName;
-    std::vector<Value*> _params;
     Value* _result;
 };
 
@@ -113,15 +143,15 @@ public:
 
     virtual std::string toString() override;
 
+    virtual Instruction* clone() override;
+
     virtual Value* getResult() override { return _result; }
 
-    Value* getPtr() { return _ptr; }
+    Value* getPtr() { return getOperand(0); }
 
-    const std::vector<Value*>& getIndexes() { return _indexes; }
+    std::vector<Value*> getIndexes();
 
 private:
-    Value* _ptr;
-    std::vector<Value*> _indexes;
     Value* _result;
 };
 
@@ -133,28 +163,32 @@ public:
 
     virtual std::string toString() override;
 
+    virtual Instruction* clone() override;
+
     virtual Value* getResult() override { return _result; }
 
-    Value* getPtr() { return _ptr; }
+    Value* getPtr() { return getOperand(0); }
 
 private:
-    Value* _ptr;
     Value* _result;
 };
 
 class ReturnInst : public Instruction {
 public:
     // retValue is nullptr when ret void
-    ReturnInst(Value* retValue = nullptr) : _retValue(retValue) {}
+    ReturnInst(Value* retValue = nullptr) {
+        if (retValue) {
+            addOperand(retValue);
+        }
+    }
 
     virtual int getClassId() override { return ID_RETURN_INST; }
 
     virtual std::string toString() override;
 
-    Value* getRetValue() { return _retValue; }
+    virtual Instruction* clone() override;
 
-private:
-    Value* _retValue;
+    Value* getRetValue() { return _operands.empty() ? nullptr : getOperand(0); }
 };
 
 class UnaryInst : public Instruction {
@@ -165,16 +199,19 @@ public:
 
     virtual std::string toString() override;
 
+    virtual Instruction* clone() override;
+
     virtual Value* getResult() override { return _result; }
 
-    Value* getOperand() { return _operand; }
+    using Instruction::getOperand;
+
+    Value* getOperand() { return getOperand(0); }
 
     int getInstType() { return _type; }
 
     enum { INST_LOAD, INST_ITOF, INST_FTOI };
 
 private:
-    Value* _operand;
     Value* _result;
     int _type;
 };
@@ -187,13 +224,15 @@ public:
 
     virtual std::string toString() override;
 
+    virtual Instruction* clone() override;
+
     virtual Value* getResult() override { return _result; }
 
-    Value* getOperand1() { return _operand1; }
+    Value* getOperand1() { return getOperand(0); }
 
-    Value* getOperand2() { return _operand2; }
+    Value* getOperand2() { return getOperand(1); }
 
-    bool isIntInst() { return _operand1->getType() == Type::getInt32Ty(); }
+    bool isIntInst() { return getOperand1()->getType() == Type::getInt32Ty(); }
 
     int getInstType() { return _type; }
 
@@ -214,8 +253,6 @@ public:
     };
 
 private:
-    Value* _operand1;
-    Value* _operand2;
     Value* _result;
     int _type;
 };
@@ -228,8 +265,12 @@ public:
 
     virtual std::string toString() override;
 
+    virtual Instruction* clone() override;
+
     BasicBlock* getTargetBB() { return _targetBB; }
 
+    void setTargetBB(BasicBlock* bb) { _targetBB = bb; }
+
 private:
     BasicBlock* _targetBB;
 };
@@ -242,27 +283,66 @@ public:
 
     virtual std::string toString() override;
 
+    virtual Instruction* clone() override;
+
     BasicBlock* getTureBB() { return _trueBB; }
 
     BasicBlock* getFalseBB() { return _falseBB; }
 
-    Value* getOperand1() { return _operand1; }
+    void setTrueBB(BasicBlock* bb) { _trueBB = bb; }
 
-    Value* getOperand2() { return _operand2; }
+    void setFalseBB(BasicBlock* bb) { _falseBB = bb; }
 
-    bool isIntInst() { return _operand1->getType() == Type::getInt32Ty(); }
+    Value* getOperand1() { return getOperand(0); }
+
+    Value* getOperand2() { return getOperand(1); }
+
+    // the pointers are compared as integers
+    bool isIntInst() { return getOperand1()->getType()->isIntType(); }
 
     int getInstType() { return _type; }
 
+    void setInstType(int type) { _type = type; }
+
     enum { INST_JLT, INST_JLE, INST_JGT, INST_JGE, INST_JEQ, INST_JNE };
 
 private:
     BasicBlock* _trueBB;
     BasicBlock* _falseBB;
-    Value* _operand1;
-    Value* _operand2;
     int _type;
 };
 
+class PhiInst : public Instruction {
+public:
+    PhiInst(Type* type, const std::string& resultName = "");
+
+    virtual int getClassId() override { return ID_PHI_INST; }
+
+    virtual std::string toString() override;
+
+    virtual Instruction* clone() override;
+
+    virtual Value* getResult() override { return _result; }
+
+    void addIncoming(Value* value, BasicBlock* bb);
+
+    std::vector<std::pair<Value*, BasicBlock*>> getIncomings();
+
+    Value* getIncomingValue(BasicBlock* bb);
+
+    void setIncomingValue(BasicBlock* bb, Value* value);
+
+    void replaceIncomingBB(BasicBlock* from, BasicBlock* to);
+
+    void removeIncoming(BasicBlock* bb);
+
+private:
+    std::vector<BasicBlock*> _incomingBBs;  // the incoming value of _incomingBBs[i] is operand i
+    Value* _result;
+};
+
+// strip the geps and bitcasts to get the base addr, which is an alloca, a global, a param or a loaded pointer
+Value* getBaseAddr(Value* addr);
+
 }  // namespace IR
 }  // namespace ATC
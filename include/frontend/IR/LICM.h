@@ -0,0 +1,40 @@
+#pragma once
+
+#include <set>
+#include <unordered_map>
+
+#include "LoopInfo.h"
+#include "Pass.h"
+
+namespace ATC {
+namespace IR {
+
+// hoist the loop invariant instructions into the preheader, the inner loops are processed first so the invariants can
+// be hoisted out of the loop nest step by step
+class LICM : public FunctionPass {
+public:
+    virtual std::string getName() override { return "licm"; }
+
+    virtual bool runOnFunction(Function* function) override;
+
+private:
+    bool insertPreheaders();
+    void insertPreheader(BasicBlock* header, const std::vector<BasicBlock*>& outsidePreds);
+
+    bool hoist(Loop* loop);
+    bool isInvariant(Value* value, Loop* loop);
+    bool canHoist(Instruction* inst, Loop* loop);
+    bool isLoadInvariant(UnaryInst* inst, Loop* loop);
+
+    // the base addrs are stripped by getBaseAddr
+    static bool mayAlias(Value* base1, Value* base2);
+
+private:
+    Function* _function;
+    std::unordered_map<Instruction*, BasicBlock*> _inst2bb;
+    bool _hasCall;                  // any call in current loop
+    std::set<Value*> _storedBases;  // base addr of the stores in current loop
+};
+
+}  // namespace IR
+}  // namespace ATC
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "BasicBlock.h"
+
+namespace ATC {
+namespace IR {
+
+// a natural loop, which is formed by all the back edges to the same header
+class Loop {
+public:
+    Loop(BasicBlock* header) : _header(header) {}
+
+    BasicBlock* getHeader() { return _header; }
+
+    Loop* getParentLoop() { return _parentLoop; }
+
+    const std::vector<Loop*>& getSubLoops() { return _subLoops; }
+
+    // all the blocks in reverse post order including the blocks of sub loops, so the header is the first one
+    const std::vector<BasicBlock*>& getBlocks() { return _blocks; }
+
+    // the blocks in loop which jump back to the header
+    const std::vector<BasicBlock*>& getLatches() { return _latches; }
+
+    // 1 for the outermost loop
+    int getDepth() { return _depth; }
+
+    bool contains(BasicBlock* bb) { return _blockSet.find(bb) != _blockSet.end(); }
+
+    bool contains(Loop* loop);
+
+    // the only predecessor of header out of loop and the header is its only successor, nullptr if not exists
+    BasicBlock* getPreheader();
+
+    // the blocks out of loop which have a predecessor in loop
+    std::vector<BasicBlock*> getExitBlocks();
+
+private:
+    friend class LoopInfo;
+
+    BasicBlock* _header;
+    Loop* _parentLoop = nullptr;
+    std::vector<Loop*> _subLoops;
+    std::vector<BasicBlock*> _blocks;
+    std::vector<BasicBlock*> _latches;
+    std::set<BasicBlock*> _blockSet;
+    int _depth = 1;
+};
+
+// the loop forest of a function, use Function::getLoopInfo() to get the cached one
+class LoopInfo {
+public:
+    LoopInfo(Function* function);
+
+    ~LoopInfo();
+
+    const std::vector<Loop*>& getTopLevelLoops() { return _topLevelLoops; }
+
+    // the inner loops come before the outer ones
+    const std::vector<Loop*>& getLoopsInPostOrder() { return _postOrderLoops; }
+
+    // the innermost loop containing the block, nullptr if it's not in any loop
+    Loop* getLoopFor(BasicBlock* bb);
+
+    // 0 if the block is not in any loop
+    int getLoopDepth(BasicBlock* bb);
+
+private:
+    void discoverLoop(BasicBlock* header, const std::vector<BasicBlock*>& latches);
+    void computePostOrder(Loop* loop);
+
+private:
+    Function* _function;
+    std::vector<Loop*> _topLevelLoops;
+    std::vector<Loop*> _postOrderLoops;
+    std::unordered_map<BasicBlock*, Loop*> _bb2loop;
+};
+
+}  // namespace IR
+}  // namespace ATC
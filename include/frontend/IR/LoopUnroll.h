@@ -0,0 +1,50 @@
+#pragma once
+
+#include <set>
+
+#include "InductionVariables.h"
+#include "Pass.h"
+
+namespace ATC {
+namespace IR {
+
+// unroll the innermost loops which exit from the header by comparing a basic induction variable with an invariant.
+// a new loop is inserted before the original one, it checks whether the next factor iterations all run and executes
+// them without testing, then the original loop executes the remaining iterations
+class LoopUnroll : public FunctionPass {
+public:
+    virtual std::string getName() override { return "loop-unroll"; }
+
+    virtual bool runOnFunction(Function* function) override;
+
+private:
+    // the loop which can be unrolled, collected before changing the cfg
+    struct UnrollCandidate {
+        std::vector<BasicBlock*> _blocks;
+        BasicBlock* _header;
+        BasicBlock* _latch;
+        BasicBlock* _preheader;
+        BasicBlock* _bodyBB;  // the successor of header in loop
+        BasicBlock* _exitBB;
+        std::vector<BasicInductionVariable> _basicIVs;
+        BasicInductionVariable _iv;  // the one compared in header
+        Value* _limit;
+        int _type;  // the loop continues if "iv type limit" is true
+    };
+
+    bool analyzeLoop(Loop* loop, UnrollCandidate& candidate);
+    void unroll(UnrollCandidate& candidate);
+
+    // -1 if unknown
+    static long long getTripCount(UnrollCandidate& candidate);
+    static int getSwappedType(int type);
+    static int getNegatedType(int type);
+    static void replaceTarget(Instruction* terminator, BasicBlock* from, BasicBlock* to);
+
+private:
+    Function* _function;
+    std::set<BasicBlock*> _visitedHeaders;
+};
+
+}  // namespace IR
+}  // namespace ATC
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <set>
+#include <unordered_map>
+
+#include "DominatorTree.h"
+#include "Pass.h"
+
+namespace ATC {
+namespace IR {
+
+// promote the scalar allocas which are only loaded and stored into SSA values
+class Mem2Reg : public FunctionPass {
+public:
+    virtual std::string getName() override { return "mem2reg"; }
+
+    virtual bool runOnFunction(Function* function) override;
+
+private:
+    void collectPromotableAllocas();
+    void insertPhis();
+    void rename();
+    // rename the loads and stores of the block, return the indexes of the pushed value stacks
+    std::vector<int> renameBlock(BasicBlock* bb);
+    void removePromotedInsts();
+
+    Value* getUndefValue(Type* type);
+
+private:
+    Function* _function;
+
+    DominatorTree* _domTree;
+    std::vector<BasicBlock*> _rpo;  // reverse post order of reachable blocks
+
+    std::vector<AllocInst*> _allocas;                // allocas which can be promoted
+    std::unordered_map<Value*, int> _alloca2index;   // alloca result to index of _allocas
+    std::unordered_map<PhiInst*, int> _phi2index;    // inserted phi to index of _allocas
+    std::vector<std::vector<Value*>> _valueStacks;  // current value of every promoted alloca
+    std::unordered_map<Value*, Value*> _replaceMap;  // result of promoted load to the loaded value
+};
+
+}  // namespace IR
+}  // namespace ATC
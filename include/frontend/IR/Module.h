@@ -7,17 +7,23 @@
 namespace ATC {
 namespace IR {
 
-class Module {
+class Module : public ArenaObject<IR_ARENA, Module> {
 public:
     Module(const std::string& name) { _name = name; }
 
     void addFunction(Function* function) { _functions.push_back(function); }
+    void removeFunction(Function* function);
     void addGlobalVariable(GloabalVariable* var) { _globalVariables.push_back(var); }
 
+    // true if no other compilation unit is linked with this one, so a function without callers is dead
+    void setIsWholeProgram(bool b) { _isWholeProgram = b; }
+
     const std::string& getName() { return _name; }
     const std::vector<Function*>& getFunctions() { return _functions; }
     const std::vector<GloabalVariable*>& getGlobalVariables() { return _globalVariables; }
 
+    bool isWholeProgram() { return _isWholeProgram; }
+
     std::string toString();
 
     void dump();
@@ -28,6 +34,7 @@ private:
     std::string _name;
     std::vector<Function*> _functions;
     std::vector<GloabalVariable*> _globalVariables;
+    bool _isWholeProgram = false;
 };
 }  // namespace IR
 }  // namespace ATC
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+
+#include "Module.h"
+
+namespace ATC {
+namespace IR {
+
+class ModulePass {
+public:
+    virtual ~ModulePass() = default;
+
+    virtual std::string getName() = 0;
+
+    // return true if the module is changed
+    virtual bool runOnModule(Module* module) = 0;
+
+    // the cached cfg analyses are kept if the pass never changes the cfg
+    virtual bool preservesCFG() { return false; }
+};
+
+class FunctionPass {
+public:
+    virtual ~FunctionPass() = default;
+
+    virtual std::string getName() = 0;
+
+    // return true if the function is changed
+    virtual bool runOnFunction(Function* function) = 0;
+
+    virtual bool preservesCFG() { return false; }
+};
+
+}  // namespace IR
+}  // namespace ATC
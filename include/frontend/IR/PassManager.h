@@ -0,0 +1,48 @@
+#pragma once
+
+#include <iostream>
+#include <map>
+
+#include "Pass.h"
+
+namespace ATC {
+namespace IR {
+
+// run a pipeline of module and function passes in the order they are added
+class PassManager {
+public:
+    PassManager() = default;
+    ~PassManager();
+
+    void addPass(ModulePass* pass);
+
+    void addPass(FunctionPass* pass);
+
+    // return true if any pass changes the module
+    bool run(Module* module);
+
+    // build the default pipeline of the optimization level
+    void buildPipeline(int optLevel);
+
+    // the time of the stages outside the pass manager, e.g. frontend and backend
+    void addTime(const std::string& name, double seconds);
+
+    void printTimeReport(std::ostream& os = std::cerr);
+
+private:
+    struct PassEntry {
+        ModulePass* _modulePass;
+        FunctionPass* _functionPass;
+    };
+
+    bool runModulePass(ModulePass* pass, Module* module);
+    bool runFunctionPass(FunctionPass* pass, Module* module);
+
+private:
+    std::vector<PassEntry> _passes;
+    std::vector<std::string> _timeOrder;          // names in the order they first run
+    std::map<std::string, double> _name2seconds;  // accumulated time of every pass
+};
+
+}  // namespace IR
+}  // namespace ATC
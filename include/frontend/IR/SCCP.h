@@ -0,0 +1,54 @@
+#pragma once
+
+#include <set>
+#include <unordered_map>
+
+#include "Pass.h"
+
+namespace ATC {
+namespace IR {
+
+// "Constant Propagation with Conditional Branches" by Wegman and Zadeck
+class SCCP : public FunctionPass {
+public:
+    virtual std::string getName() override { return "sccp"; }
+
+    virtual bool runOnFunction(Function* function) override;
+
+    // nullptr if the result is undefined and left to runtime
+    static Constant* foldBinary(int type, Constant* operand1, Constant* operand2);
+    static Constant* foldUnary(int type, Constant* operand);
+
+private:
+    struct LatticeValue {
+        enum { UNDEF, CONST, OVERDEFINED } _state = UNDEF;
+        Constant* _constant = nullptr;
+    };
+
+    LatticeValue getLatticeValue(Value* value);
+    void setLatticeValue(Value* value, const LatticeValue& latticeValue);
+    void markOverdefined(Value* value);
+    void markEdgeExecutable(BasicBlock* from, BasicBlock* to);
+
+    void visitInst(Instruction* inst);
+    void visitPhi(PhiInst* inst);
+    void visitBinary(BinaryInst* inst);
+    void visitUnary(UnaryInst* inst);
+    void visitCondJump(CondJumpInst* inst);
+
+    bool rewrite();
+
+    static bool foldCondJump(int type, Constant* operand1, Constant* operand2);
+
+private:
+    Function* _function;
+    std::unordered_map<Value*, LatticeValue> _lattice;
+    std::unordered_map<Instruction*, BasicBlock*> _inst2bb;
+    std::set<BasicBlock*> _executableBBs;
+    std::set<std::pair<BasicBlock*, BasicBlock*>> _executableEdges;
+    std::vector<BasicBlock*> _bbWorklist;
+    std::vector<Instruction*> _instWorklist;  // the users of values whose lattice value is changed
+};
+
+}  // namespace IR
+}  // namespace ATC
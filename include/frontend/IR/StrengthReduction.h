@@ -0,0 +1,64 @@
+#pragma once
+
+#include <map>
+#include <unordered_map>
+
+#include "InductionVariables.h"
+#include "Pass.h"
+
+namespace ATC {
+namespace IR {
+
+// replace the geps whose index is an affine function of induction variable by pointers increased in every iteration,
+// then replace the exit compare of induction variable by the compare of pointer if the induction variable becomes
+// useless (linear function test replacement)
+class StrengthReduction : public FunctionPass {
+public:
+    virtual std::string getName() override { return "strength-reduce"; }
+
+    virtual bool runOnFunction(Function* function) override;
+
+    virtual bool preservesCFG() override { return true; }
+
+private:
+    // the geps with the same base and affine index except the constant share one pointer, e.g. a[i] and a[i + 1]
+    struct PointerKey {
+        Value* _ptr;
+        std::vector<Value*> _leadingIndexes;
+        BasicInductionVariable* _iv;
+        int _scale;
+        std::vector<std::pair<Value*, int>> _terms;
+
+        bool operator<(const PointerKey& other) const;
+    };
+
+    struct PointerIV {
+        PhiInst* _phi;
+        PointerKey _key;
+        int _constant;  // the constant of the first gep, others are addressed by the offset to it
+    };
+
+    bool reduceLoop(Loop* loop);
+    bool replaceTest(InductionVariables& ivs, BasicInductionVariable& iv);
+
+    // the limit of the replaced compare is expr with the iv replaced by the limit, computed in int32. it must not
+    // overflow where the compare of the iv doesn't
+    static bool isLimitInRange(const AffineExpression& expr, Value* limit);
+    // the sum of the constant terms of expr with the iv replaced by the value given
+    static long long foldConstant(const AffineExpression& expr, Value* ivValue);
+    // compute the value of expr in preheader, the iv is replaced by the value given. the folded constant is in int32
+    Value* materialize(const AffineExpression& expr, Value* ivValue);
+    Value* createGEPInPreheader(const PointerKey& key, Value* index);
+    Instruction* insertBefore(Instruction* pos, Instruction* inst);
+    Instruction* insertBeforeTerminator(BasicBlock* bb, Instruction* inst);
+    void eraseDeadInst(Instruction* inst);
+
+private:
+    Function* _function;
+    BasicBlock* _preheader;
+    std::map<PointerKey, PointerIV> _pointerIVs;
+    std::unordered_map<Instruction*, BasicBlock*> _inst2bb;
+};
+
+}  // namespace IR
+}  // namespace ATC
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Pass.h"
+
+namespace ATC {
+namespace IR {
+
+// turn the self calls whose result is returned directly into jumps back to the beginning of function, the params
+// become the phis there. the calls like "return x + f(...)" are also eliminated by an accumulator if they use the same
+// int operator, which is applied to the values returned by the other returns
+class TailRecursionElimination : public FunctionPass {
+public:
+    virtual std::string getName() override { return "tre"; }
+
+    virtual bool runOnFunction(Function* function) override;
+
+private:
+    struct TailCall {
+        BasicBlock* _bb;
+        FunctionCallInst* _call;
+        BinaryInst* _accumulate;  // nullptr if the result is returned directly
+        Value* _operand;          // the other operand of accumulate
+    };
+
+    bool findTailCall(BasicBlock* bb, TailCall& tailCall);
+
+    void eliminate(const std::vector<TailCall>& tailCalls, BasicBlock* beginBB, int accumulateType);
+
+private:
+    Function* _function;
+};
+
+}  // namespace IR
+}  // namespace ATC
@@ -1,18 +1,48 @@
 #pragma once
 
 #include <iostream>
+#include <vector>
 
+#include "../Arena.h"
 #include "Type.h"
 namespace ATC {
 namespace IR {
 
 class Function;
 class Instruction;
+class Value;
 
-class Value {
+// an edge of the def-use chain, it links into the intrusive use list of the used value
+class Use : public ArenaObject<IR_ARENA, Use> {
+public:
+    Use(Value* value, Instruction* user);
+
+    Value* get() { return _value; }
+
+    void set(Value* value);
+
+    Instruction* getUser() { return _user; }
+
+    Use* getNext() { return _next; }
+
+    // unlink from the use list of the value, the use is dead after that
+    void removeFromList();
+
+private:
+    void addToList();
+
+    Value* _value;
+    Instruction* _user;
+    Use* _next = nullptr;
+    Use** _prev = nullptr;  // the next field of previous use or the head of use list
+};
+
+class Value : public ArenaObject<IR_ARENA, Value> {
 public:
     Value(Type* type, const std::string& name) : _type(type), _name(name) {}
 
+    virtual ~Value() = default;
+
     void setName(const std::string& name) { _name = name; }
 
     void setBelongAndInsertName(Function* function);
@@ -25,6 +55,15 @@ public:
 
     Instruction* getDefined() { return _defined; }
 
+    bool hasUses() { return _useList != nullptr; }
+
+    std::vector<Use*> getUses();
+
+    // an instruction appears once for every operand using this value
+    std::vector<Instruction*> getUsers();
+
+    void replaceAllUsesWith(Value* value);
+
     virtual std::string getValueStr();
 
     virtual std::string toString();
@@ -40,17 +79,32 @@ protected:
     std::string _name;
     Function* _belong = nullptr;
     Instruction* _defined = nullptr;
+
+private:
+    friend class Use;
+    friend class Constant;
+    Use* _useList = nullptr;
 };
 
 class Constant : public Value {
 public:
     Constant(Type* type) : Value(type, "") {}
 
+    // the constants are uniqued for the whole process, so they are never in the arena
+    static void* operator new(size_t size) { return ::operator new(size); }
+    static void operator delete(void* ptr) { ::operator delete(ptr); }
+
     virtual bool isConst() override { return true; }
 
     virtual std::string getLiteralStr() = 0;
 
     virtual bool isInt() = 0;
+
+    // the uses of constants are in the ir arena of the current compilation unit, drop them before it's released
+    static void clearUseLists();
+
+protected:
+    static std::vector<Constant*> AllConstants;
 };
 
 class ConstantInt : public Constant {
@@ -1,5 +1,7 @@
 #include "CmdOption.h"
 
+#include "llvm/Pass.h"
+
 namespace ATC {
 llvm::cl::OptionCategory MyCategory("ATC");
 
@@ -36,4 +38,56 @@ llvm::cl::opt<bool> Check("check", llvm::cl::desc("check after running"), llvm::
 llvm::cl::opt<std::string> CompareFile("compare-file",
                                        llvm::cl::desc("right output for program which will run after compiling"),
                                        llvm::cl::cat(MyCategory));
+
+bool OptLevelParser::parse(llvm::cl::Option& option, llvm::StringRef argName, llvm::StringRef arg, unsigned& value) {
+    if (llvm::cl::parser<unsigned>::parse(option, argName, arg, value)) {
+        return true;
+    }
+    if (value > 2) {
+        return option.error("'" + arg + "' is not a valid optimization level, use 0, 1 or 2");
+    }
+    return false;
+}
+
+llvm::cl::opt<unsigned, false, OptLevelParser> OptLevel("O", llvm::cl::desc("optimization level: -O0, -O1 or -O2"),
+                                                        llvm::cl::Prefix, llvm::cl::init(2),
+                                                        llvm::cl::cat(MyCategory));
+
+llvm::cl::opt<unsigned> UnrollFactor("unroll-factor",
+                                     llvm::cl::desc("the unrolled times of a loop body, 1 disables unrolling"),
+                                     llvm::cl::init(4), llvm::cl::cat(MyCategory));
+
+llvm::cl::opt<unsigned> UnrollBudget("unroll-budget",
+                                     llvm::cl::desc("the max number of instructions of an unrolled loop body"),
+                                     llvm::cl::init(256), llvm::cl::cat(MyCategory));
+
+// "regalloc" has been registered by libLLVM, so use another name
+llvm::cl::opt<RegAllocKind> RegAlloc("reg-alloc",
+                                     llvm::cl::desc("the register allocator, linear by default at -O0 and graph otherwise"),
+                                     llvm::cl::values(clEnumValN(GRAPH_REG_ALLOC, "graph", "graph coloring"),
+                                                      clEnumValN(LINEAR_REG_ALLOC, "linear", "linear scan")),
+                                     llvm::cl::init(DEFAULT_REG_ALLOC), llvm::cl::cat(MyCategory));
+
+llvm::cl::opt<bool> PeepholeStats("peephole-stats", llvm::cl::desc("print the hit count of every peephole rule"),
+                                  llvm::cl::init(false), llvm::cl::cat(MyCategory));
+
+llvm::cl::opt<CpuKind> Mcpu("mcpu",
+                            llvm::cl::desc("the pipeline model for instruction scheduling, u74 by default and none at -O0"),
+                            llvm::cl::values(clEnumValN(U74_CPU, "u74", "dual-issue in-order"),
+                                             clEnumValN(GENERIC_CPU, "generic", "single-issue in-order"),
+                                             clEnumValN(NO_CPU, "none", "no scheduling")),
+                            llvm::cl::init(DEFAULT_CPU), llvm::cl::cat(MyCategory));
+
+// "time-passes" has been registered by libLLVM, define it again will abort, so reuse the llvm one
+bool& TimePasses = llvm::TimePassesIsEnabled;
+
+void initSharedOptions() {
+    auto& options = llvm::cl::getRegisteredOptions();
+    auto iter = options.find("time-passes");
+    if (iter != options.end()) {
+        iter->second->addCategory(MyCategory);
+        iter->second->setHiddenFlag(llvm::cl::NotHidden);
+        iter->second->setDescription("print the time spent in every pass");
+    }
+}
 }  // namespace ATC
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "riscv/BlockPlacement.h"
+
+#include <assert.h>
+
+#include <algorithm>
+
+namespace ATC {
+
+namespace RISCV {
+
+void BlockPlacement::run() {
+    auto& bbs = _theFunction->getMutableBasicBlocks();
+    std::vector<BasicBlock*> order(bbs.begin(), bbs.end());
+    if (order.size() < 3) {
+        return;
+    }
+    _chains.clear();
+    _bb2chain.clear();
+    for (auto bb : order) {
+        _bb2chain[bb] = _chains.size();
+        _chains.push_back({bb});
+    }
+    for (size_t i = 0; i + 1 < order.size(); i++) {
+        if (isFallThrough(order[i])) {
+            mergeChain(order[i], order[i + 1]);
+        }
+    }
+
+    // a block runs about 10 times per iteration of its loop
+    auto getFrequency = [](int depth) {
+        long long frequency = 1;
+        for (int i = 0; i < depth && i < 9; i++) {
+            frequency *= 10;
+        }
+        return frequency;
+    };
+    std::vector<Edge> edges;
+    for (auto bb : order) {
+        for (auto succ : bb->getSuccessors()) {
+            if (succ != bb && succ != order.front()) {
+                int depth = std::min(bb->getLoopDepth(), succ->getLoopDepth());
+                edges.push_back({bb, succ, getFrequency(depth)});
+            }
+        }
+    }
+    // the ties keep the original order, which is reverse post order
+    std::stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a._weight > b._weight; });
+    for (auto& edge : edges) {
+        mergeChain(edge._from, edge._to);
+    }
+
+    // the entry chain is the first, the others are in the order of their heads
+    bbs.clear();
+    std::vector<bool> placed(_chains.size(), false);
+    for (auto bb : order) {
+        int chain = _bb2chain[bb];
+        if (placed[chain] || _chains[chain].empty()) {
+            continue;
+        }
+        placed[chain] = true;
+        bbs.insert(bbs.end(), _chains[chain].begin(), _chains[chain].end());
+    }
+    assert(bbs.size() == order.size() && bbs.front() == order.front());
+
+    for (auto iter = bbs.begin(); iter != bbs.end(); iter++) {
+        auto next = std::next(iter);
+        if (next != bbs.end()) {
+            fixTerminator(*iter, *next);
+        }
+    }
+}
+
+bool BlockPlacement::isFallThrough(BasicBlock* bb) {
+    auto& instList = bb->getInstructionList();
+    if (instList.empty()) {
+        return true;
+    }
+    auto last = instList.back();
+    switch (last->getClassId()) {
+        case ID_JUMP_INST:
+        case ID_RETURN_INST:
+            return false;
+        case ID_FUNCTION_CALL_INST:
+            return !static_cast<FunctionCallInst*>(last)->isTail();
+        default:
+            return true;
+    }
+}
+
+void BlockPlacement::mergeChain(BasicBlock* from, BasicBlock* to) {
+    int fromChain = _bb2chain[from];
+    int toChain = _bb2chain[to];
+    if (fromChain == toChain || _chains[fromChain].back() != from || _chains[toChain].front() != to) {
+        return;
+    }
+    for (auto bb : _chains[toChain]) {
+        _bb2chain[bb] = fromChain;
+        _chains[fromChain].push_back(bb);
+    }
+    _chains[toChain].clear();
+}
+
+void BlockPlacement::fixTerminator(BasicBlock* bb, BasicBlock* next) {
+    auto& instList = bb->getMutableInstructionList();
+    if (instList.size() < 2) {
+        return;
+    }
+    auto last = instList.back();
+    auto condJump = *std::prev(instList.end(), 2);
+    if (last->getClassId() != ID_JUMP_INST || condJump->getClassId() != ID_COND_JUMP_INST) {
+        return;
+    }
+    auto jump = static_cast<JumpInst*>(last);
+    auto cond = static_cast<CondJumpInst*>(condJump);
+    if (cond->getTargetBB() != next || jump->getTargetBB() == next) {
+        return;
+    }
+    // b.cc next; j other -> b.!cc other; j next, the jump is removed as redundant later
+    switch (cond->getInstType()) {
+        case CondJumpInst::INST_BEQ:
+            cond->setInstType(CondJumpInst::INST_BNE);
+            break;
+        case CondJumpInst::INST_BNE:
+            cond->setInstType(CondJumpInst::INST_BEQ);
+            break;
+        case CondJumpInst::INST_BLT:
+            cond->setInstType(CondJumpInst::INST_BGE);
+            break;
+        case CondJumpInst::INST_BGE:
+            cond->setInstType(CondJumpInst::INST_BLT);
+            break;
+        default:
+            assert(0 && "can't not reach here");
+            break;
+    }
+    cond->setTargetBB(jump->getTargetBB());
+    jump->setTargetBB(next);
+}
+
+}  // namespace RISCV
+}  // namespace ATC
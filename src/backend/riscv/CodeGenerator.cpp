@@ -2,10 +2,17 @@
 
 #include <assert.h>
 
+#include <memory>
+
+#include "../CmdOption.h"
 #include "IR/Instruction.h"
+#include "IR/LoopInfo.h"
 #include "IR/Module.h"
 #include "riscv/BasicBlock.h"
+#include "riscv/BlockPlacement.h"
 #include "riscv/Function.h"
+#include "riscv/InstScheduler.h"
+#include "riscv/PeepholeOptimizer.h"
 #include "riscv/RegAllocator.h"
 
 namespace ATC {
@@ -13,6 +20,28 @@ namespace RISCV {
 
 using std::endl;
 
+static bool isImm12(int imm) { return imm >= -2048 && imm <= 2047; }
+
+static int getInvertedCondJump(int type) {
+    switch (type) {
+        case IR::CondJumpInst::INST_JLT:
+            return IR::CondJumpInst::INST_JGE;
+        case IR::CondJumpInst::INST_JLE:
+            return IR::CondJumpInst::INST_JGT;
+        case IR::CondJumpInst::INST_JGT:
+            return IR::CondJumpInst::INST_JLE;
+        case IR::CondJumpInst::INST_JGE:
+            return IR::CondJumpInst::INST_JLT;
+        case IR::CondJumpInst::INST_JEQ:
+            return IR::CondJumpInst::INST_JNE;
+        case IR::CondJumpInst::INST_JNE:
+            return IR::CondJumpInst::INST_JEQ;
+        default:
+            assert(0 && "can't not reach here");
+            return -1;
+    }
+}
+
 int BasicBlock::Index = 0;
 int Register::Index = 0;
 
@@ -29,6 +58,10 @@ std::vector<Register*> Register::IntArgReg;
 std::vector<Register*> Register::FloatArgReg;
 
 CodeGenerator::CodeGenerator() {
+    // the fixed regs are in the heap and shared by all the compilation units
+    if (Register::Ra != nullptr) {
+        return;
+    }
     Register::Ra = new Register();
     Register::Ra->setName("ra");
     Register::Ra->setIsFixed(true);
@@ -146,6 +179,10 @@ void CodeGenerator::emitFunction(IR::Function* function) {
 
     std::set<Register*> tmpNeedPushRegs;
 
+    // every attempt emits the machine code into a new arena, the last one is released after printing
+    std::unique_ptr<Arena> arena;
+    ArenaScope arenaScope(MACHINE_ARENA, nullptr);
+
     do {
         tmpNeedPushRegs = _currentFunction->getNeedPushRegs();
 
@@ -153,10 +190,17 @@ void CodeGenerator::emitFunction(IR::Function* function) {
         _offset = 0;
         _value2reg.clear();
         _value2offset.clear();
+        _foldedAddrs.clear();
+        _fusedCompares.clear();
         _paramInStack.clear();
         _IRBB2asmBB.clear();
         _maxPassParamsStackOffset = 0;
+        _tailCallBBs.clear();
+        _tailCallRets.clear();
         _currentFunction->getMutableBasicBlocks().clear();
+        _currentFunction->getNeedAllocRegs().clear();
+        arena = std::make_unique<Arena>();
+        Arena::setCurrent(MACHINE_ARENA, arena.get());
 
         if (function->hasFunctionCall()) {
             // save ra and s0
@@ -191,14 +235,40 @@ void CodeGenerator::emitFunction(IR::Function* function) {
         }
         _retBB = new BasicBlock("." + function->getName() + "_ret");
 
-        _currentFunction->addBasicBlock(_entryBB);
+        // the result of phi is defined in every predecessor, so create its reg in advance
         for (auto bb : function->getBasicBlocks()) {
+            for (auto inst : bb->getInstructionList()) {
+                if (inst->getClassId() == IR::ID_PHI_INST && !inst->isDead()) {
+                    _value2reg[inst->getResult()] = new Register(inst->getResult()->getType()->isIntType());
+                }
+            }
+        }
+
+        _currentFunction->addBasicBlock(_entryBB);
+        _currentBasicBlock = _IRBB2asmBB[function->getBasicBlocks().front()];
+        emitParams(function);
+        // a value is always emitted before its uses in reverse post order
+        for (auto bb : function->getReversePostOrder()) {
             emitBasicBlock(bb);
         }
         _currentFunction->addBasicBlock(_retBB);
 
-        RegAllocator regAllocator(_currentFunction, _offset, true);
+        // the linear scan is much faster on the large functions, but the code is worse
+        bool useGraphColoring = RegAlloc == DEFAULT_REG_ALLOC ? OptLevel != 0 : RegAlloc == GRAPH_REG_ALLOC;
+        // hide the latencies of the loads and the long operations on the in-order cores
+        auto cpu = Mcpu == DEFAULT_CPU ? (OptLevel != 0 ? U74_CPU : NO_CPU) : Mcpu.getValue();
+        auto schedModel = cpu == NO_CPU ? nullptr : SchedModel::get(cpu == U74_CPU ? "u74" : "generic");
+        assert((cpu == NO_CPU || schedModel) && "the cpu should have a model");
+        PeepholeOptimizer(_currentFunction, false).run();
+        if (schedModel) {
+            InstScheduler(_currentFunction, schedModel, false).run();
+        }
+        RegAllocator regAllocator(_currentFunction, _offset, useGraphColoring);
         regAllocator.run();
+        PeepholeOptimizer(_currentFunction, true).run();
+        if (schedModel) {
+            InstScheduler(_currentFunction, schedModel, true).run();
+        }
     } while (tmpNeedPushRegs != _currentFunction->getNeedPushRegs());
 
     _offset -= _maxPassParamsStackOffset;
@@ -213,68 +283,56 @@ void CodeGenerator::emitFunction(IR::Function* function) {
             pushRegOffset = -_offset - 24;
             _entryBB->addInstruction(new StoreInst(StoreInst::INST_SD, Register::Ra, Register::Sp, -_offset - 8));
             _entryBB->addInstruction(new StoreInst(StoreInst::INST_SD, Register::S0, Register::Sp, -_offset - 16));
-            _retBB->addInstruction(new LoadInst(LoadInst::INST_LD, Register::Ra, Register::Sp, -_offset - 8));
-            _retBB->addInstruction(new LoadInst(LoadInst::INST_LD, Register::S0, Register::Sp, -_offset - 16));
         } else {
             pushRegOffset = -_offset - 16;
             _entryBB->addInstruction(new StoreInst(StoreInst::INST_SD, Register::S0, Register::Sp, -_offset - 8));
-            _retBB->addInstruction(new LoadInst(LoadInst::INST_LD, Register::S0, Register::Sp, -_offset - 8));
         }
         for (auto reg : _currentFunction->getNeedPushRegs()) {
-            if (reg->isIntReg()) {
-                _entryBB->addInstruction(new StoreInst(StoreInst::INST_SD, reg, Register::Sp, pushRegOffset));
-                _retBB->addInstruction(new LoadInst(LoadInst::INST_LD, reg, Register::Sp, pushRegOffset));
-            } else {
-                _entryBB->addInstruction(new StoreInst(StoreInst::INST_FSD, reg, Register::Sp, pushRegOffset));
-                _retBB->addInstruction(new LoadInst(LoadInst::INST_FLD, reg, Register::Sp, pushRegOffset));
-            }
+            int type = reg->isIntReg() ? StoreInst::INST_SD : StoreInst::INST_FSD;
+            _entryBB->addInstruction(new StoreInst(type, reg, Register::Sp, pushRegOffset));
             pushRegOffset -= 8;
         }
 
         _entryBB->addInstruction(new BinaryInst(BinaryInst::INST_ADDI, Register::S0, Register::Sp, -_offset));
-        _retBB->addInstruction(new BinaryInst(BinaryInst::INST_ADDI, Register::Sp, Register::Sp, -_offset));
     } else {
         // 2032 avoid to ues the num 2048
         _entryBB->addInstruction(new BinaryInst(BinaryInst::INST_ADDI, Register::Sp, Register::Sp, -2032));
-        _currentBasicBlock = _retBB;
-        auto tmpImm = loadConstInt(-_offset - 2032);
-        tmpImm->setName("t0");
-        tmpImm->setIsFixed(true);
-        _currentBasicBlock->addInstruction(new BinaryInst(BinaryInst::INST_ADD, Register::Sp, Register::Sp, tmpImm));
         int pushRegOffset;
         if (function->hasFunctionCall()) {
             pushRegOffset = 2008;
             _entryBB->addInstruction(new StoreInst(StoreInst::INST_SD, Register::Ra, Register::Sp, 2024));
             _entryBB->addInstruction(new StoreInst(StoreInst::INST_SD, Register::S0, Register::Sp, 2016));
-            _retBB->addInstruction(new LoadInst(LoadInst::INST_LD, Register::Ra, Register::Sp, 2024));
-            _retBB->addInstruction(new LoadInst(LoadInst::INST_LD, Register::S0, Register::Sp, 2016));
         } else {
             pushRegOffset = 2016;
             _entryBB->addInstruction(new StoreInst(StoreInst::INST_SD, Register::S0, Register::Sp, 2024));
-            _retBB->addInstruction(new LoadInst(LoadInst::INST_LD, Register::S0, Register::Sp, 2024));
         }
         for (auto reg : _currentFunction->getNeedPushRegs()) {
-            if (reg->isIntReg()) {
-                _entryBB->addInstruction(new StoreInst(StoreInst::INST_SD, reg, Register::Sp, pushRegOffset));
-                _retBB->addInstruction(new LoadInst(LoadInst::INST_LD, reg, Register::Sp, pushRegOffset));
-            } else {
-                _entryBB->addInstruction(new StoreInst(StoreInst::INST_FSD, reg, Register::Sp, pushRegOffset));
-                _retBB->addInstruction(new LoadInst(LoadInst::INST_FLD, reg, Register::Sp, pushRegOffset));
-            }
+            int type = reg->isIntReg() ? StoreInst::INST_SD : StoreInst::INST_FSD;
+            _entryBB->addInstruction(new StoreInst(type, reg, Register::Sp, pushRegOffset));
             pushRegOffset -= 8;
         }
 
         _entryBB->addInstruction(new BinaryInst(BinaryInst::INST_ADDI, Register::S0, Register::Sp, 2032));
 
         _currentBasicBlock = _entryBB;
-        tmpImm = loadConstInt(_offset + 2032);
+        auto tmpImm = loadConstInt(_offset + 2032);
         tmpImm->setName("t0");
         tmpImm->setIsFixed(true);
         _currentBasicBlock->addInstruction(new BinaryInst(BinaryInst::INST_ADD, Register::Sp, Register::Sp, tmpImm));
-        _retBB->addInstruction(new BinaryInst(BinaryInst::INST_ADDI, Register::Sp, Register::Sp, 2032));
     }
 
+    emitEpilogue(function, _retBB);
     _retBB->addInstruction(new ReturnInst());
+    // the tail calls release the frame before jumping to the callee
+    for (auto bb : _tailCallBBs) {
+        auto tailCall = bb->getInstructionList().back();
+        assert(tailCall->getClassId() == ID_FUNCTION_CALL_INST && "the tail call should end the block");
+        bb->getMutableInstructionList().pop_back();
+        emitEpilogue(function, bb);
+        bb->addInstruction(tailCall);
+    }
+
+    BlockPlacement(_currentFunction).run();
 
     // remove redundant jump and lable
     for (auto begin = _currentFunction->getBasicBlocks().begin(); begin != _currentFunction->getBasicBlocks().end();
@@ -286,9 +344,8 @@ void CodeGenerator::emitFunction(IR::Function* function) {
         auto lastInst = tmpBB->getInstructionList().back();
         if (lastInst->getClassId() == ID_JUMP_INST) {
             BasicBlock* targetBB = static_cast<JumpInst*>(lastInst)->getTargetBB();
-            auto nextBBIter = begin;
-            auto nextBB = *++nextBBIter;
-            if (nextBB == targetBB) {
+            auto nextBBIter = std::next(begin);
+            if (nextBBIter != _currentFunction->getBasicBlocks().end() && *nextBBIter == targetBB) {
                 tmpBB->getMutableInstructionList().pop_back();
                 if (targetBB->getPredecessors().size() == 1) {
                     targetBB->setIsNeedLable(false);
@@ -297,10 +354,123 @@ void CodeGenerator::emitFunction(IR::Function* function) {
         }
     }
     _contend << _currentFunction->toString();
+    delete _currentFunction;
+    _currentFunction = nullptr;
+}
+
+void CodeGenerator::emitEpilogue(IR::Function* function, BasicBlock* bb) {
+    // restore the regs saved by prologue and release the frame
+    _currentBasicBlock = bb;
+    int frameOffset = _offset >= -2048 ? -_offset : 2032;
+    if (_offset < -2048) {
+        auto tmpImm = loadConstInt(-_offset - 2032);
+        tmpImm->setName("t0");
+        tmpImm->setIsFixed(true);
+        bb->addInstruction(new BinaryInst(BinaryInst::INST_ADD, Register::Sp, Register::Sp, tmpImm));
+    }
+    int pushRegOffset;
+    if (function->hasFunctionCall()) {
+        pushRegOffset = frameOffset - 24;
+        bb->addInstruction(new LoadInst(LoadInst::INST_LD, Register::Ra, Register::Sp, frameOffset - 8));
+        bb->addInstruction(new LoadInst(LoadInst::INST_LD, Register::S0, Register::Sp, frameOffset - 16));
+    } else {
+        pushRegOffset = frameOffset - 16;
+        bb->addInstruction(new LoadInst(LoadInst::INST_LD, Register::S0, Register::Sp, frameOffset - 8));
+    }
+    for (auto reg : _currentFunction->getNeedPushRegs()) {
+        int type = reg->isIntReg() ? LoadInst::INST_LD : LoadInst::INST_FLD;
+        bb->addInstruction(new LoadInst(type, reg, Register::Sp, pushRegOffset));
+        pushRegOffset -= 8;
+    }
+    bb->addInstruction(new BinaryInst(BinaryInst::INST_ADDI, Register::Sp, Register::Sp, frameOffset));
+}
+
+void CodeGenerator::emitParams(IR::Function* function) {
+    // the params stored to their allocas are handled by emitStoreInst
+    std::set<IR::Value*> usedValues;
+    for (auto bb : function->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            if (inst->isDead()) {
+                continue;
+            }
+            if (inst->getClassId() == IR::ID_STORE_INST) {
+                auto dest = static_cast<IR::StoreInst*>(inst)->getDest()->getDefined();
+                if (dest && dest->getClassId() == IR::ID_ALLOC_INST &&
+                    static_cast<IR::AllocInst*>(dest)->isAllocForParam()) {
+                    continue;
+                }
+            }
+            for (auto operand : inst->getOperands()) {
+                usedValues.insert(operand);
+            }
+        }
+    }
+
+    // copy the params to virtual regs, the arg regs may be overwritten by function call
+    int stackOffset = 0;
+    for (auto param : function->getParams()) {
+        if (_paramInStack.find(param) != _paramInStack.end()) {
+            // the params in stack are loaded when they are used
+            _value2offset[param] = stackOffset;
+            stackOffset += 8;
+            continue;
+        }
+        if (usedValues.find(param) == usedValues.end()) {
+            continue;
+        }
+        Instruction* copyInst;
+        if (param->getType()->isIntType()) {
+            copyInst = new UnaryInst(UnaryInst::INST_MV, _value2reg[param]);
+        } else {
+            copyInst = new UnaryInst(UnaryInst::INST_FMV_S, _value2reg[param]);
+        }
+        _currentBasicBlock->addInstruction(copyInst);
+        _value2reg[param] = copyInst->getDest();
+    }
+}
+
+void CodeGenerator::emitPhiCopies(IR::BasicBlock* from, IR::BasicBlock* to) {
+    std::vector<std::pair<Register*, IR::Value*>> copies;
+    std::set<Register*> phiRegs;
+    for (auto inst : to->getInstructionList()) {
+        if (inst->getClassId() != IR::ID_PHI_INST) {
+            break;
+        }
+        if (inst->isDead()) {
+            continue;
+        }
+        auto phi = (IR::PhiInst*)inst;
+        Register* dest = _value2reg[phi->getResult()];
+        copies.push_back({dest, phi->getIncomingValue(from)});
+        phiRegs.insert(dest);
+    }
+
+    // the phis are executed in parallel, save the result of other phi before it is overwritten
+    std::vector<std::pair<Register*, Register*>> moves;
+    for (auto [dest, value] : copies) {
+        Register* src = getRegFromValue(value);
+        if (src != dest && phiRegs.find(src) != phiRegs.end()) {
+            auto saveInst = new UnaryInst(src->isIntReg() ? UnaryInst::INST_MV : UnaryInst::INST_FMV_S, src);
+            _currentBasicBlock->addInstruction(saveInst);
+            src = saveInst->getDest();
+        }
+        moves.push_back({dest, src});
+    }
+    for (auto [dest, src] : moves) {
+        if (dest != src) {
+            _currentBasicBlock->addInstruction(
+                new UnaryInst(dest->isIntReg() ? UnaryInst::INST_MV : UnaryInst::INST_FMV_S, dest, src));
+        }
+    }
 }
 
 void CodeGenerator::emitBasicBlock(IR::BasicBlock* basicBlock) {
+    _currentIRBasicBlock = basicBlock;
     _currentBasicBlock = _IRBB2asmBB[basicBlock];
+    auto loopInfo = basicBlock->getParent()->getLoopInfo();
+    _currentBasicBlock->setLoopDepth(loopInfo->getLoopDepth(basicBlock));
+    auto loop = loopInfo->getLoopFor(basicBlock);
+    _currentBasicBlock->setIsLoopHeader(loop && loop->getHeader() == basicBlock);
     _currentFunction->addBasicBlock(_currentBasicBlock);
     for (auto inst : basicBlock->getInstructionList()) {
         emitInstruction(inst);
@@ -338,12 +508,16 @@ void CodeGenerator::emitInstruction(IR::Instruction* inst) {
             break;
         case IR::ID_JUMP_INST: {
             IR::JumpInst* jumpInst = (IR::JumpInst*)inst;
+            emitPhiCopies(_currentIRBasicBlock, jumpInst->getTargetBB());
             _currentBasicBlock->addInstruction(new JumpInst(_IRBB2asmBB[jumpInst->getTargetBB()]));
             break;
         }
         case IR::ID_COND_JUMP_INST:
             emitCondJumpInst((IR::CondJumpInst*)inst);
             break;
+        case IR::ID_PHI_INST:
+            // the phi is lowered to copies in its predecessors
+            break;
         default:
             assert(false && "should not reach here");
             break;
@@ -352,6 +526,7 @@ void CodeGenerator::emitInstruction(IR::Instruction* inst) {
 
 void CodeGenerator::emitAllocInst(IR::AllocInst* inst) {
     _value2reg[inst->getResult()] = Register::S0;
+    _foldedAddrs.insert(inst->getResult());
 
     auto type = inst->getResult()->getType()->getBaseType();
     if (inst->isAllocForParam()) {
@@ -371,11 +546,13 @@ void CodeGenerator::emitAllocInst(IR::AllocInst* inst) {
 
 void CodeGenerator::emitStoreInst(IR::StoreInst* inst) {
     auto value = inst->getValue();
-    /// needn't to store
-    if (_paramInStack.find(value) != _paramInStack.end()) {
+    auto dest = inst->getDest();
+    /// needn't to store, the alloca of param in stack points to the param directly
+    if (_paramInStack.find(value) != _paramInStack.end() && dest->getDefined() &&
+        dest->getDefined()->getClassId() == IR::ID_ALLOC_INST &&
+        static_cast<IR::AllocInst*>(dest->getDefined())->isAllocForParam()) {
         return;
     }
-    auto dest = inst->getDest();
     Register* src1 = getRegFromValue(value);
     Register* src2 = getRegFromValue(dest);
     int offset = _value2offset[dest];
@@ -394,7 +571,39 @@ void CodeGenerator::emitStoreInst(IR::StoreInst* inst) {
     _currentBasicBlock->addInstruction(new StoreInst(instType, src1, src2, offset));
 }
 
+IR::ReturnInst* CodeGenerator::getTailCallRet(IR::FunctionCallInst* inst) {
+    // the args in stack and the local memory are in the frame released before the tail call, so the pointer args
+    // should be based on the params or the global variables
+    int intNum = 0;
+    int floatNum = 0;
+    for (auto param : inst->getParams()) {
+        if (param->getType()->isIntType()) {
+            intNum++;
+        } else {
+            floatNum++;
+        }
+        if (param->getType()->isPointerType() && IR::getBaseAddr(param)->getDefined()) {
+            return nullptr;
+        }
+    }
+    if (intNum > 8 || floatNum > 8) {
+        return nullptr;
+    }
+
+    auto& instList = _currentIRBasicBlock->getInstructionList();
+    auto next = std::next(std::find(instList.begin(), instList.end(), inst));
+    while (next != instList.end() && (*next)->isDead()) {
+        next++;
+    }
+    if (next == instList.end() || (*next)->getClassId() != IR::ID_RETURN_INST) {
+        return nullptr;
+    }
+    auto ret = (IR::ReturnInst*)*next;
+    return ret->getRetValue() == inst->getResult() ? ret : nullptr;
+}
+
 void CodeGenerator::emitFunctionCallInst(IR::FunctionCallInst* inst) {
+    auto tailCallRet = getTailCallRet(inst);
     int intOrder = 0;
     int floatOrder = 0;
     int stackOffset = 0;
@@ -405,38 +614,11 @@ void CodeGenerator::emitFunctionCallInst(IR::FunctionCallInst* inst) {
                 _currentBasicBlock->addInstruction(
                     new UnaryInst(UnaryInst::INST_MV, Register::IntArgReg[intOrder++], paramReg));
             } else {
-                auto& mutableInstList = _currentBasicBlock->getMutableInstructionList();
-                auto begin = mutableInstList.begin();
-                auto end = mutableInstList.end();
-                for (; begin != end; begin++) {
-                    if ((*begin)->getDest() == paramReg) {
-                        ++begin;
-                        if (stackOffset > 2047) {
-                            auto hi20 = stackOffset >> 12;
-                            auto lo12 = stackOffset & 0xfff;
-                            if (lo12 > 2047) {
-                                lo12 -= 4096;
-                                hi20 += 1;
-                            }
-                            auto lui = new ImmInst(ImmInst::INST_LUI, hi20);
-                            mutableInstList.insert(begin, lui);
-
-                            auto add = new BinaryInst(BinaryInst::INST_ADD, Register::Sp, lui->getDest());
-                            mutableInstList.insert(begin, add);
-
-                            auto saveParam = new StoreInst(
-                                param->getType()->isPointerType() ? StoreInst::INST_SD : StoreInst::INST_SW, paramReg,
-                                add->getDest(), lo12);
-                            mutableInstList.insert(begin, saveParam);
-                        } else {
-                            auto saveParam = new StoreInst(
-                                param->getType()->isPointerType() ? StoreInst::INST_SD : StoreInst::INST_SW, paramReg,
-                                Register::Sp, stackOffset);
-                            mutableInstList.insert(begin, saveParam);
-                        }
-                        break;
-                    }
-                }
+                // store the param to stack just before the call
+                int offset = stackOffset;
+                auto base = processIfImmOutOfRange(Register::Sp, offset);
+                int type = param->getType()->isPointerType() ? StoreInst::INST_SD : StoreInst::INST_SW;
+                _currentBasicBlock->addInstruction(new StoreInst(type, paramReg, base, offset));
                 stackOffset += 8;
             }
         } else {
@@ -444,34 +626,9 @@ void CodeGenerator::emitFunctionCallInst(IR::FunctionCallInst* inst) {
                 _currentBasicBlock->addInstruction(
                     new UnaryInst(UnaryInst::INST_FMV_S, Register::FloatArgReg[floatOrder++], paramReg));
             } else {
-                auto& mutableInstList = _currentBasicBlock->getMutableInstructionList();
-                auto begin = mutableInstList.begin();
-                auto end = mutableInstList.end();
-                for (; begin != end; begin++) {
-                    if ((*begin)->getDest() == paramReg) {
-                        ++begin;
-                        if (stackOffset > 2047) {
-                            auto hi20 = stackOffset >> 12;
-                            auto lo12 = stackOffset & 0xfff;
-                            if (lo12 > 2047) {
-                                lo12 -= 4096;
-                                hi20 += 1;
-                            }
-                            auto lui = new ImmInst(ImmInst::INST_LUI, hi20);
-                            mutableInstList.insert(begin, lui);
-
-                            auto add = new BinaryInst(BinaryInst::INST_ADD, Register::Sp, lui->getDest());
-                            mutableInstList.insert(begin, add);
-
-                            auto saveParam = new StoreInst(StoreInst::INST_FSW, paramReg, add->getDest(), lo12);
-                            mutableInstList.insert(begin, saveParam);
-                        } else {
-                            auto saveParam = new StoreInst(StoreInst::INST_FSW, paramReg, Register::Sp, stackOffset);
-                            mutableInstList.insert(begin, saveParam);
-                        }
-                        break;
-                    }
-                }
+                int offset = stackOffset;
+                auto base = processIfImmOutOfRange(Register::Sp, offset);
+                _currentBasicBlock->addInstruction(new StoreInst(StoreInst::INST_FSW, paramReg, base, offset));
                 stackOffset += 8;
             }
         }
@@ -485,7 +642,7 @@ void CodeGenerator::emitFunctionCallInst(IR::FunctionCallInst* inst) {
             dest = Register::FloatArgReg[0];
         }
     }
-    auto call = new FunctionCallInst(inst->getFuncName(), dest);
+    auto call = new FunctionCallInst(inst->getFuncName(), dest, tailCallRet != nullptr);
 
     for (int i = 0; i < intOrder; i++) {
         call->addUsedReg(Register::IntArgReg[i]);
@@ -494,6 +651,12 @@ void CodeGenerator::emitFunctionCallInst(IR::FunctionCallInst* inst) {
         call->addUsedReg(Register::FloatArgReg[i]);
     }
     _currentBasicBlock->addInstruction(call);
+    if (tailCallRet) {
+        // the callee returns to our caller with the result in a0 or fa0
+        _tailCallBBs.push_back(_currentBasicBlock);
+        _tailCallRets.insert(tailCallRet);
+        return;
+    }
     if (inst->getResult()) {
         Instruction* mv;
         if (inst->getResult()->getType() == IR::Type::getInt32Ty()) {
@@ -507,68 +670,83 @@ void CodeGenerator::emitFunctionCallInst(IR::FunctionCallInst* inst) {
 }
 
 void CodeGenerator::emitGEPInst(IR::GetElementPtrInst* inst) {
+    // the result is ptr + offset, the constant part is kept in offset
     Register* ptr = getRegFromValue(inst->getPtr());
-    if (ptr == Register::S0) {
-        int offset = _value2offset[inst->getPtr()];
+    int offset = _foldedAddrs.count(inst->getPtr()) ? _value2offset[inst->getPtr()] : 0;
+    auto indexes = inst->getIndexes();
+    if (indexes.back()->isConst()) {
+        int index = static_cast<IR::ConstantInt*>(indexes.back())->getConstValue();
+        offset += index * (indexes.size() == 1 ? inst->getPtr()->getType()->getBaseType()->getByteLen() : 4);
+    } else {
+        ptr = emitGEPIndex(inst, ptr);
+    }
+
+    if (isImm12(offset) && isAddressOnly(inst->getResult())) {
+        _value2reg[inst->getResult()] = ptr;
+        _value2offset[inst->getResult()] = offset;
+        _foldedAddrs.insert(inst->getResult());
+        return;
+    }
+    // such as the induction pointer of strength reduction
+    if (offset != 0 || ptr == Register::S0) {
         auto tmp = processIfImmOutOfRange(ptr, offset);
-        auto getPtr = new BinaryInst(BinaryInst::INST_ADDI, tmp, offset);
-        ptr = getPtr->getDest();
-        _currentBasicBlock->addInstruction(getPtr);
+        auto addi = new BinaryInst(BinaryInst::INST_ADDI, tmp, offset);
+        _currentBasicBlock->addInstruction(addi);
+        ptr = addi->getDest();
     }
+    _value2reg[inst->getResult()] = ptr;
+}
+
+Register* CodeGenerator::emitGEPIndex(IR::GetElementPtrInst* inst, Register* ptr) {
     Register* offsetReg;
-    auto& indexes = inst->getIndexes();
+    auto indexes = inst->getIndexes();
     if (indexes.size() == 1) {
         int offset = inst->getPtr()->getType()->getBaseType()->getByteLen();
-        if (indexes[0]->isConst()) {
-            offset *= static_cast<IR::ConstantInt*>(indexes[0])->getConstValue();
-            auto li = new ImmInst(ImmInst::INST_LI, offset);
-            _currentBasicBlock->addInstruction(li);
-            offsetReg = li->getDest();
+        if (offset == 4) {
+            auto slli = new BinaryInst(BinaryInst::INST_SLLI, getRegFromValue(indexes[0]), 2);
+            _currentBasicBlock->addInstruction(slli);
+            offsetReg = slli->getDest();
         } else {
-            if (offset == 4) {
-                auto slli = new BinaryInst(BinaryInst::INST_SLLI, _value2reg[indexes[0]], 2);
-                _currentBasicBlock->addInstruction(slli);
-                offsetReg = slli->getDest();
-            } else {
-                auto li = new ImmInst(ImmInst::INST_LI, offset);
-                _currentBasicBlock->addInstruction(li);
-                auto mul = new BinaryInst(BinaryInst::INST_MUL, _value2reg[indexes[0]], li->getDest());
-                _currentBasicBlock->addInstruction(mul);
-                offsetReg = mul->getDest();
-            }
-        }
-    } else {
-        if (indexes[1]->isConst()) {
-            int offset = 4 * static_cast<IR::ConstantInt*>(indexes[1])->getConstValue();
             auto li = new ImmInst(ImmInst::INST_LI, offset);
             _currentBasicBlock->addInstruction(li);
-            offsetReg = li->getDest();
-        } else {
-            /// FIXME: the imm should be 3 when base type if array of pointer
-            auto slli = new BinaryInst(BinaryInst::INST_SLLI, _value2reg[indexes[1]], 2);
-            _currentBasicBlock->addInstruction(slli);
-            offsetReg = slli->getDest();
+            auto mul = new BinaryInst(BinaryInst::INST_MUL, getRegFromValue(indexes[0]), li->getDest());
+            _currentBasicBlock->addInstruction(mul);
+            offsetReg = mul->getDest();
         }
+    } else {
+        /// FIXME: the imm should be 3 when base type if array of pointer
+        auto slli = new BinaryInst(BinaryInst::INST_SLLI, getRegFromValue(indexes[1]), 2);
+        _currentBasicBlock->addInstruction(slli);
+        offsetReg = slli->getDest();
     }
     auto add = new BinaryInst(BinaryInst::INST_ADD, ptr, offsetReg);
     _currentBasicBlock->addInstruction(add);
-    _value2reg[inst->getResult()] = add->getDest();
+    return add->getDest();
 }
 
 void CodeGenerator::emitBitCastInst(IR::BitCastInst* inst) {
     Register* ptr = getRegFromValue(inst->getPtr());
-    if (ptr == Register::S0) {
-        int offset = _value2offset[inst->getPtr()];
-        auto tmp = processIfImmOutOfRange(Register::S0, offset);
-        auto getPtr = new BinaryInst(BinaryInst::INST_ADDI, tmp, offset);
-        _currentBasicBlock->addInstruction(getPtr);
-        _value2reg[inst->getResult()] = getPtr->getDest();
-    } else {
+    if (!_foldedAddrs.count(inst->getPtr())) {
         _value2reg[inst->getResult()] = ptr;
+        return;
+    }
+    int offset = _value2offset[inst->getPtr()];
+    if (isImm12(offset) && isAddressOnly(inst->getResult())) {
+        _value2reg[inst->getResult()] = ptr;
+        _value2offset[inst->getResult()] = offset;
+        _foldedAddrs.insert(inst->getResult());
+        return;
     }
+    auto tmp = processIfImmOutOfRange(ptr, offset);
+    auto getPtr = new BinaryInst(BinaryInst::INST_ADDI, tmp, offset);
+    _currentBasicBlock->addInstruction(getPtr);
+    _value2reg[inst->getResult()] = getPtr->getDest();
 }
 
 void CodeGenerator::emitRetInst(IR::ReturnInst* inst) {
+    if (_tailCallRets.find(inst) != _tailCallRets.end()) {
+        return;
+    }
     if (inst->getRetValue()) {
         auto retValue = getRegFromValue(inst->getRetValue());
         if (inst->getRetValue()->getType() == IR::Type::getInt32Ty()) {
@@ -608,6 +786,9 @@ void CodeGenerator::emitUnaryInst(IR::UnaryInst* inst) {
                     auto oneBB = new BasicBlock();
                     auto zeroBB = new BasicBlock();
                     auto afterBB = new BasicBlock();
+                    oneBB->setLoopDepth(_currentBasicBlock->getLoopDepth());
+                    zeroBB->setLoopDepth(_currentBasicBlock->getLoopDepth());
+                    afterBB->setLoopDepth(_currentBasicBlock->getLoopDepth());
                     _currentFunction->addBasicBlock(oneBB);
                     _currentFunction->addBasicBlock(zeroBB);
                     _currentFunction->addBasicBlock(afterBB);
@@ -644,6 +825,10 @@ void CodeGenerator::emitUnaryInst(IR::UnaryInst* inst) {
 }
 
 void CodeGenerator::emitBinaryInst(IR::BinaryInst* inst) {
+    if (isFusedCompare(inst)) {
+        _fusedCompares.insert(inst->getResult());
+        return;
+    }
     auto dest = inst->getResult();
     auto operand1 = inst->getOperand1();
     auto operand2 = inst->getOperand2();
@@ -655,12 +840,39 @@ void CodeGenerator::emitBinaryInst(IR::BinaryInst* inst) {
 }
 
 void CodeGenerator::emitCondJumpInst(IR::CondJumpInst* inst) {
-    Register* src1 = getRegFromValue(inst->getOperand1());
-    Register* src2 = getRegFromValue(inst->getOperand2());
+    int condType = inst->getInstType();
+    auto operand1 = inst->getOperand1();
+    auto operand2 = inst->getOperand2();
+    bool isInt = inst->isIntInst();
+    bool inverted = false;
+    if (_fusedCompares.count(operand1)) {
+        // branch on x < y directly for (x < y) != 0 and (x < y) == 1, otherwise on the inverted compare
+        auto compare = static_cast<IR::BinaryInst*>(operand1->getDefined());
+        int constant = static_cast<IR::ConstantInt*>(operand2)->getConstValue();
+        inverted = (condType == IR::CondJumpInst::INST_JNE) == (constant != 0);
+        // the compares and the cond jumps are in the same order
+        condType = compare->getInstType() - IR::BinaryInst::INST_LT + IR::CondJumpInst::INST_JLT;
+        operand1 = compare->getOperand1();
+        operand2 = compare->getOperand2();
+        isInt = compare->isIntInst();
+        if (isInt && inverted) {
+            condType = getInvertedCondJump(condType);
+            inverted = false;
+        }
+    }
+    auto getSrc = [this](IR::Value* value) {
+        if (value->isConst() && static_cast<IR::Constant*>(value)->isInt() &&
+            static_cast<IR::ConstantInt*>(value)->getConstValue() == 0) {
+            return Register::Zero;
+        }
+        return getRegFromValue(value);
+    };
+    Register* src1 = getSrc(operand1);
+    Register* src2 = getSrc(operand2);
 
     int type;
-    if (inst->isIntInst()) {
-        switch (inst->getInstType()) {
+    if (isInt) {
+        switch (condType) {
             case IR::CondJumpInst::INST_JEQ:
                 type = CondJumpInst::INST_BEQ;
                 break;
@@ -688,7 +900,7 @@ void CodeGenerator::emitCondJumpInst(IR::CondJumpInst* inst) {
     } else {
         Instruction* cmpInst;
         type = CondJumpInst::INST_BNE;
-        switch (inst->getInstType()) {
+        switch (condType) {
             case IR::CondJumpInst::INST_JEQ:
                 cmpInst = new BinaryInst(BinaryInst::INST_FEQ_S, src1, src2);
                 break;
@@ -714,13 +926,33 @@ void CodeGenerator::emitCondJumpInst(IR::CondJumpInst* inst) {
         }
         _currentBasicBlock->addInstruction(cmpInst);
         src1 = cmpInst->getDest();
-        src2 = loadConstInt(0);
+        src2 = Register::Zero;
+        // the float compares can't be inverted because of NaN, so branch on the result being 0
+        if (inverted) {
+            type = type == CondJumpInst::INST_BNE ? CondJumpInst::INST_BEQ : CondJumpInst::INST_BNE;
+        }
     }
     _currentBasicBlock->addInstruction(new CondJumpInst(type, src1, src2, _IRBB2asmBB[inst->getTureBB()]));
     _currentBasicBlock->addInstruction(new JumpInst(_IRBB2asmBB[inst->getFalseBB()]));
 }
 
 Register* CodeGenerator::emitIntBinaryInst(int instType, IR::Value* operand1, IR::Value* operand2) {
+    if ((instType == IR::BinaryInst::INST_DIV || instType == IR::BinaryInst::INST_MOD) && !operand1->isConst() &&
+        operand2->isConst()) {
+        int divisor = static_cast<IR::ConstantInt*>(operand2)->getConstValue();
+        if (divisor != 0 && divisor != INT32_MIN) {
+            return emitDivByConst(getRegFromValue(operand1), divisor, instType == IR::BinaryInst::INST_MOD);
+        }
+    }
+    if (instType == IR::BinaryInst::INST_MUL && !operand1->isConst() && operand2->isConst()) {
+        int factor = static_cast<IR::ConstantInt*>(operand2)->getConstValue();
+        if (factor > 0 && (factor & (factor - 1)) == 0) {
+            auto slliw = new BinaryInst(BinaryInst::INST_SLLIW, getRegFromValue(operand1), __builtin_ctz(factor));
+            _currentBasicBlock->addInstruction(slliw);
+            return slliw->getDest();
+        }
+    }
+
     Register* src1;
     Register* src2 = nullptr;
     int imm;
@@ -888,6 +1120,92 @@ Register* CodeGenerator::emitIntBinaryInst(int instType, IR::Value* operand1, IR
     return dest;
 }
 
+Register* CodeGenerator::emitDivByConst(Register* dividend, int divisor, bool isMod) {
+    // x % d = x % -d, and x / d = -(x / -d)
+    int absDivisor = divisor > 0 ? divisor : -divisor;
+    auto addInst = [this](Instruction* inst) {
+        _currentBasicBlock->addInstruction(inst);
+        return inst->getDest();
+    };
+
+    Register* quotient;
+    if (absDivisor == 1) {
+        if (isMod) {
+            return loadConstInt(0);
+        }
+        quotient = addInst(new UnaryInst(UnaryInst::INST_MV, dividend));
+    } else if ((absDivisor & (absDivisor - 1)) == 0) {
+        // round toward zero by adding 2^k - 1 to the negative dividend before the arithmetic shift
+        int k = __builtin_ctz(absDivisor);
+        auto bias = dividend;
+        if (k > 1) {
+            bias = addInst(new BinaryInst(BinaryInst::INST_SRAIW, dividend, 31));
+        }
+        bias = addInst(new BinaryInst(BinaryInst::INST_SRLIW, bias, 32 - k));
+        auto biased = addInst(new BinaryInst(BinaryInst::INST_ADDW, dividend, bias));
+        quotient = addInst(new BinaryInst(BinaryInst::INST_SRAIW, biased, k));
+        if (isMod) {
+            auto product = addInst(new BinaryInst(BinaryInst::INST_SLLI, quotient, k));
+            return addInst(new BinaryInst(BinaryInst::INST_SUBW, dividend, product));
+        }
+    } else {
+        // the 64-bit product of the sign-extended operands holds the high word of the 32-bit multiplication
+        int magic, shift;
+        getDivMagic(absDivisor, magic, shift);
+        auto product = addInst(new BinaryInst(BinaryInst::INST_MUL, dividend, loadConstInt(magic)));
+        if (magic < 0) {
+            // the magic number is greater than 2^31, the dividend is added back to correct it
+            auto high = addInst(new BinaryInst(BinaryInst::INST_SRAI, product, 32));
+            auto sum = addInst(new BinaryInst(BinaryInst::INST_ADDW, high, dividend));
+            product = addInst(new BinaryInst(BinaryInst::INST_SRAIW, sum, shift));
+        } else {
+            product = addInst(new BinaryInst(BinaryInst::INST_SRAI, product, 32 + shift));
+        }
+        // add 1 if the dividend is negative
+        auto sign = addInst(new BinaryInst(BinaryInst::INST_SRLIW, dividend, 31));
+        quotient = addInst(new BinaryInst(BinaryInst::INST_ADDW, product, sign));
+        if (isMod) {
+            product = addInst(new BinaryInst(BinaryInst::INST_MULW, quotient, loadConstInt(absDivisor)));
+            return addInst(new BinaryInst(BinaryInst::INST_SUBW, dividend, product));
+        }
+    }
+
+    if (divisor < 0) {
+        quotient = addInst(new BinaryInst(BinaryInst::INST_SUBW, Register::Zero, quotient));
+    }
+    return quotient;
+}
+
+void CodeGenerator::getDivMagic(int divisor, int& magic, int& shift) {
+    const uint32_t two31 = 0x80000000;
+    uint32_t ad = divisor;
+    uint32_t anc = two31 - 1 - two31 % ad;
+    uint32_t q1 = two31 / anc;
+    uint32_t r1 = two31 - q1 * anc;
+    uint32_t q2 = two31 / ad;
+    uint32_t r2 = two31 - q2 * ad;
+    uint32_t delta;
+    int p = 31;
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) {
+            q1++;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= ad) {
+            q2++;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+    magic = (int)(q2 + 1);
+    shift = p - 32;
+}
+
 Register* CodeGenerator::emitFloatBinaryInst(int instType, IR::Value* operand1, IR::Value* operand2) {
     Register* src1 = getRegFromValue(operand1);
     Register* src2 = getRegFromValue(operand2);
@@ -975,11 +1293,82 @@ Register* CodeGenerator::getRegFromValue(IR::Value* value) {
         return la->getDest();
     }
 
+    if (_paramInStack.find(value) != _paramInStack.end()) {
+        int type;
+        if (value->getType()->isPointerType()) {
+            type = LoadInst::INST_LD;
+        } else if (value->getType()->isIntType()) {
+            type = LoadInst::INST_LW;
+        } else {
+            type = LoadInst::INST_FLW;
+        }
+        int offset = _value2offset[value];
+        auto src = processIfImmOutOfRange(Register::S0, offset);
+        auto load = new LoadInst(type, src, offset);
+        _currentBasicBlock->addInstruction(load);
+        return load->getDest();
+    }
+
     return _value2reg[value];
 }
 
+bool CodeGenerator::isFusedCompare(IR::BinaryInst* inst) {
+    auto terminator = _currentIRBasicBlock->getInstructionList().back();
+    if (inst->getInstType() < IR::BinaryInst::INST_LT || terminator->getClassId() != IR::ID_COND_JUMP_INST) {
+        return false;
+    }
+    auto condJump = static_cast<IR::CondJumpInst*>(terminator);
+    int type = condJump->getInstType();
+    if ((type != IR::CondJumpInst::INST_JEQ && type != IR::CondJumpInst::INST_JNE) ||
+        condJump->getOperand1() != inst->getResult() || !condJump->getOperand2()->isConst() ||
+        !condJump->isIntInst()) {
+        return false;
+    }
+    int constant = static_cast<IR::ConstantInt*>(condJump->getOperand2())->getConstValue();
+    if (constant != 0 && constant != 1) {
+        return false;
+    }
+    for (auto user : inst->getResult()->getUsers()) {
+        if (user != condJump && !user->isDead()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CodeGenerator::isAddressOnly(IR::Value* value) {
+    for (auto use : value->getUses()) {
+        auto user = use->getUser();
+        if (user->isDead()) {
+            continue;
+        }
+        switch (user->getClassId()) {
+            case IR::ID_UNARY_INST:
+                if (static_cast<IR::UnaryInst*>(user)->getInstType() != IR::UnaryInst::INST_LOAD) {
+                    return false;
+                }
+                break;
+            case IR::ID_STORE_INST:
+                if (static_cast<IR::StoreInst*>(user)->getValue() == value) {
+                    return false;
+                }
+                break;
+            case IR::ID_GET_ELEMENT_PTR_INST:
+                if (static_cast<IR::GetElementPtrInst*>(user)->getPtr() != value) {
+                    return false;
+                }
+                break;
+            case IR::ID_BITCAST_INST:
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
 Register* CodeGenerator::processIfImmOutOfRange(Register* src, int& offset) {
-    if (offset < -2048 || offset > 2047) {
+    if (!isImm12(offset)) {
         int hi20 = (unsigned)offset >> 12;
         int lo12 = offset & 0xfff;
         if (lo12 > 2047) {
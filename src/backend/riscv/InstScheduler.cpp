@@ -0,0 +1,289 @@
+#include "riscv/InstScheduler.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace ATC {
+
+namespace RISCV {
+
+// the U74 is dual-issue, a divide blocks its unit for up to 60 cycles, take a typical one
+static const SchedModel SchedModels[] = {
+    {"u74", 2, {1, 3, 1, 3, 20, 5, 20, 4, 2}},
+    {"generic", 1, {1, 2, 1, 3, 20, 4, 20, 3, 2}},
+};
+
+int SchedModel::getUnit(int instClass) {
+    switch (instClass) {
+        case LOAD:
+        case STORE:
+            return MEM_UNIT;
+        case MUL:
+        case DIV:
+            return MUL_UNIT;
+        case FP:
+        case FDIV:
+        case FP_CVT:
+        case FP_MV:
+            return FP_UNIT;
+        default:
+            return NO_UNIT;
+    }
+}
+
+const SchedModel* SchedModel::get(const std::string& name) {
+    for (auto& model : SchedModels) {
+        if (name == model._name) {
+            return &model;
+        }
+    }
+    return nullptr;
+}
+
+void InstScheduler::run() {
+    for (auto bb : _theFunction->getBasicBlocks()) {
+        auto& instList = bb->getMutableInstructionList();
+        auto begin = instList.begin();
+        for (auto iter = instList.begin(); iter != instList.end(); iter++) {
+            if (isBarrier(*iter)) {
+                scheduleRegion(begin, iter);
+                begin = std::next(iter);
+            }
+        }
+        scheduleRegion(begin, instList.end());
+    }
+}
+
+void InstScheduler::scheduleRegion(InstIter begin, InstIter end) {
+    _nodes.clear();
+    for (auto iter = begin; iter != end; iter++) {
+        Node node;
+        node._inst = *iter;
+        node._class = getInstClass(*iter);
+        _nodes.push_back(node);
+    }
+    int size = _nodes.size();
+    if (size < 2) {
+        return;
+    }
+    buildDependences();
+
+    // the edges go forward, so the nodes are in topological order
+    for (int i = size - 1; i >= 0; i--) {
+        auto& node = _nodes[i];
+        node._height = _model->_latencies[node._class];
+        for (auto& succ : node._succs) {
+            node._height = std::max(node._height, succ.second + _nodes[succ.first]._height);
+        }
+    }
+
+    std::vector<int> ready;
+    for (int i = 0; i < size; i++) {
+        if (_nodes[i]._predNum == 0) {
+            ready.push_back(i);
+        }
+    }
+    std::vector<int> order;
+    for (int cycle = 0; (int)order.size() < size; cycle++) {
+        bool unitUsed[SchedModel::UNIT_NUM] = {};
+        for (int issued = 0; issued < _model->_issueWidth; issued++) {
+            int best = -1;
+            for (auto i : ready) {
+                auto& node = _nodes[i];
+                int unit = SchedModel::getUnit(node._class);
+                if (node._earliest > cycle || (unit != SchedModel::NO_UNIT && unitUsed[unit])) {
+                    continue;
+                }
+                if (!_isAllocated && i >= (int)order.size() + PreAllocWindow) {
+                    continue;
+                }
+                if (best == -1 || node._height > _nodes[best]._height ||
+                    (node._height == _nodes[best]._height && i < best)) {
+                    best = i;
+                }
+            }
+            if (best == -1) {
+                break;
+            }
+            ready.erase(std::find(ready.begin(), ready.end(), best));
+            order.push_back(best);
+            unitUsed[SchedModel::getUnit(_nodes[best]._class)] = true;
+            // a succ with 0 latency may issue later in the same cycle
+            for (auto& succ : _nodes[best]._succs) {
+                auto& node = _nodes[succ.first];
+                node._earliest = std::max(node._earliest, cycle + succ.second);
+                if (--node._predNum == 0) {
+                    ready.push_back(succ.first);
+                }
+            }
+        }
+    }
+
+    for (auto i : order) {
+        *begin++ = _nodes[i]._inst;
+    }
+    assert(begin == end);
+}
+
+void InstScheduler::buildDependences() {
+    std::unordered_map<std::string, int> lastDef;
+    std::unordered_map<std::string, std::vector<int>> usesSinceDef;
+    std::unordered_map<std::string, int> defNum;
+    std::vector<int> memNodes;
+    for (int i = 0; i < (int)_nodes.size(); i++) {
+        auto& node = _nodes[i];
+        auto inst = node._inst;
+        bool isStore = inst->getClassId() == ID_STORE_INST;
+        bool isLoad = inst->getClassId() == ID_LOAD_INST;
+
+        for (auto src : {inst->getSrc1(), inst->getSrc2()}) {
+            if (!src || src == Register::Zero) {
+                continue;
+            }
+            auto iter = lastDef.find(src->getName());
+            if (iter != lastDef.end()) {
+                addDependence(iter->second, i, _model->_latencies[_nodes[iter->second]._class]);
+            }
+            usesSinceDef[src->getName()].push_back(i);
+        }
+
+        if (isLoad || isStore) {
+            // the base is read before the load defines its dest
+            auto base = isStore ? inst->getSrc2() : inst->getSrc1();
+            node._base = base->getName();
+            node._baseVersion = defNum[node._base];
+            node._offset = inst->getImm();
+            node._width = getAccessWidth(inst);
+            for (auto j : memNodes) {
+                bool isPrevStore = _nodes[j]._inst->getClassId() == ID_STORE_INST;
+                if ((isStore || isPrevStore) && mayAlias(_nodes[j], node)) {
+                    addDependence(j, i, isPrevStore && isLoad ? 1 : 0);
+                }
+            }
+            memNodes.push_back(i);
+        }
+
+        auto dest = inst->getDest();
+        if (!dest || dest == Register::Zero) {
+            continue;
+        }
+        auto& name = dest->getName();
+        auto iter = lastDef.find(name);
+        if (iter != lastDef.end()) {
+            addDependence(iter->second, i, 1);
+        }
+        for (auto j : usesSinceDef[name]) {
+            if (j != i) {
+                addDependence(j, i, 0);
+            }
+        }
+        usesSinceDef[name].clear();
+        lastDef[name] = i;
+        defNum[name]++;
+    }
+}
+
+void InstScheduler::addDependence(int from, int to, int latency) {
+    _nodes[from]._succs.push_back({to, latency});
+    _nodes[to]._predNum++;
+}
+
+bool InstScheduler::mayAlias(const Node& a, const Node& b) {
+    if (a._base != b._base || a._baseVersion != b._baseVersion) {
+        return true;
+    }
+    return a._offset < b._offset + b._width && b._offset < a._offset + a._width;
+}
+
+bool InstScheduler::isBarrier(Instruction* inst) {
+    switch (inst->getClassId()) {
+        case ID_JUMP_INST:
+        case ID_COND_JUMP_INST:
+        case ID_FUNCTION_CALL_INST:
+        case ID_RETURN_INST:
+            return true;
+        default:
+            return false;
+    }
+}
+
+int InstScheduler::getInstClass(Instruction* inst) {
+    auto type = inst->getInstType();
+    switch (inst->getClassId()) {
+        case ID_LOAD_INST:
+            return SchedModel::LOAD;
+        case ID_STORE_INST:
+            return SchedModel::STORE;
+        case ID_UNARY_INST:
+            switch (type) {
+                case UnaryInst::INST_FMV_S:
+                case UnaryInst::INST_FMV_W_X:
+                    return SchedModel::FP_MV;
+                case UnaryInst::INST_FCVT_S_W:
+                case UnaryInst::INST_FCVT_W_S:
+                    return SchedModel::FP_CVT;
+                default:
+                    return SchedModel::ALU;
+            }
+        case ID_BINARY_INST:
+            switch (type) {
+                case BinaryInst::INST_MUL:
+                case BinaryInst::INST_MULW:
+                    return SchedModel::MUL;
+                case BinaryInst::INST_DIV:
+                case BinaryInst::INST_REM:
+                case BinaryInst::INST_DIVW:
+                case BinaryInst::INST_REMW:
+                    return SchedModel::DIV;
+                case BinaryInst::INST_FADD_S:
+                case BinaryInst::INST_FSUB_S:
+                case BinaryInst::INST_FMUL_S:
+                    return SchedModel::FP;
+                case BinaryInst::INST_FDIV_S:
+                    return SchedModel::FDIV;
+                case BinaryInst::INST_FLT_S:
+                case BinaryInst::INST_FLE_S:
+                case BinaryInst::INST_FEQ_S:
+                    return SchedModel::FP_CVT;
+                default:
+                    return SchedModel::ALU;
+            }
+        default:
+            return SchedModel::ALU;
+    }
+}
+
+int InstScheduler::getAccessWidth(Instruction* inst) {
+    auto type = inst->getInstType();
+    if (inst->getClassId() == ID_LOAD_INST) {
+        switch (type) {
+            case LoadInst::INST_LB:
+            case LoadInst::INST_LBU:
+                return 1;
+            case LoadInst::INST_LH:
+            case LoadInst::INST_LHU:
+                return 2;
+            case LoadInst::INST_LD:
+            case LoadInst::INST_FLD:
+                return 8;
+            default:
+                return 4;
+        }
+    }
+    switch (type) {
+        case StoreInst::INST_SB:
+            return 1;
+        case StoreInst::INST_SH:
+            return 2;
+        case StoreInst::INST_SD:
+        case StoreInst::INST_FSD:
+            return 8;
+        default:
+            return 4;
+    }
+}
+
+}  // namespace RISCV
+}  // namespace ATC
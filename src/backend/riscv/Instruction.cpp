@@ -90,8 +90,16 @@ std::string BinaryInst::toString() {
             return "xori\t" + _dest->getName() + ", " + _src1->getName() + ", " + std::to_string(_imm);
         case INST_SLLI:
             return "slli\t" + _dest->getName() + ", " + _src1->getName() + ", " + std::to_string(_imm);
+        case INST_SRAI:
+            return "srai\t" + _dest->getName() + ", " + _src1->getName() + ", " + std::to_string(_imm);
         case INST_ADDIW:
             return "addiw\t" + _dest->getName() + ", " + _src1->getName() + ", " + std::to_string(_imm);
+        case INST_SLLIW:
+            return "slliw\t" + _dest->getName() + ", " + _src1->getName() + ", " + std::to_string(_imm);
+        case INST_SRAIW:
+            return "sraiw\t" + _dest->getName() + ", " + _src1->getName() + ", " + std::to_string(_imm);
+        case INST_SRLIW:
+            return "srliw\t" + _dest->getName() + ", " + _src1->getName() + ", " + std::to_string(_imm);
         case INST_ADD:
             return "add\t" + _dest->getName() + ", " + _src1->getName() + ", " + _src2->getName();
         case INST_SUB:
@@ -0,0 +1,72 @@
+#include "riscv/InterferenceGraph.h"
+
+#include <assert.h>
+
+#include <algorithm>
+
+namespace ATC {
+
+namespace RISCV {
+
+InterferenceGraph::InterferenceGraph(int size, int precoloredNum)
+    : _size(size), _precoloredNum(precoloredNum), _matrix((getBitIndex(0, size) + 63) / 64, 0), _adjLists(size) {}
+
+std::size_t InterferenceGraph::getBitIndex(int a, int b) {
+    if (a > b) {
+        std::swap(a, b);
+    }
+    // the row b holds the nodes [0, b)
+    return (std::size_t)b * (b - 1) / 2 + a;
+}
+
+void InterferenceGraph::addEdge(int a, int b) {
+    assert(a != b && "self interference");
+    if (isPrecolored(a) && isPrecolored(b)) {
+        return;
+    }
+    std::size_t index = getBitIndex(a, b);
+    uint64_t mask = (uint64_t)1 << (index % 64);
+    if (_matrix[index / 64] & mask) {
+        return;
+    }
+    _matrix[index / 64] |= mask;
+    if (!isPrecolored(a)) {
+        _adjLists[a].push_back(b);
+    }
+    if (!isPrecolored(b)) {
+        _adjLists[b].push_back(a);
+    }
+}
+
+bool InterferenceGraph::hasEdge(int a, int b) const {
+    if (a == b) {
+        return false;
+    }
+    std::size_t index = getBitIndex(a, b);
+    return _matrix[index / 64] & ((uint64_t)1 << (index % 64));
+}
+
+void InterferenceGraph::removeEdge(int a, int b) {
+    std::size_t index = getBitIndex(a, b);
+    _matrix[index / 64] &= ~((uint64_t)1 << (index % 64));
+    if (!isPrecolored(b)) {
+        auto& adjList = _adjLists[b];
+        adjList.erase(std::find(adjList.begin(), adjList.end(), a));
+    }
+}
+
+void InterferenceGraph::merge(int from, int to) {
+    assert(!isPrecolored(from) && "the precolored node can't be merged");
+    auto neighbours = std::move(_adjLists[from]);
+    _adjLists[from].clear();
+    for (auto neighbour : neighbours) {
+        removeEdge(from, neighbour);
+        if (neighbour != to) {
+            addEdge(neighbour, to);
+        }
+    }
+}
+
+}  // namespace RISCV
+
+}  // namespace ATC
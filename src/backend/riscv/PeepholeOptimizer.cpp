@@ -0,0 +1,309 @@
+#include "riscv/PeepholeOptimizer.h"
+
+#include <assert.h>
+
+namespace ATC {
+
+namespace RISCV {
+
+std::vector<PeepholeOptimizer::Rule> PeepholeOptimizer::Rules = {
+    {"self-move", &PeepholeOptimizer::removeSelfMove, true, true, 0},
+    {"zero-imm-to-move", &PeepholeOptimizer::zeroImmToMove, true, true, 0},
+    {"store-to-load", &PeepholeOptimizer::forwardStoreToLoad, true, true, 0},
+    {"li-zero", &PeepholeOptimizer::useZeroReg, true, false, 0},
+    {"bool-chain", &PeepholeOptimizer::foldBoolChain, true, false, 0},
+    {"dead-def", &PeepholeOptimizer::removeDeadDef, true, false, 0},
+};
+
+bool PeepholeOptimizer::run() {
+    if (!_isAllocated) {
+        buildDefUse();
+    }
+
+    bool changed = false;
+    for (auto bb : _theFunction->getBasicBlocks()) {
+        auto& instList = bb->getMutableInstructionList();
+        for (auto iter = instList.begin(); iter != instList.end();) {
+            bool matched = false;
+            for (auto& rule : Rules) {
+                if (!(_isAllocated ? rule._afterAlloc : rule._beforeAlloc)) {
+                    continue;
+                }
+                if ((this->*rule._func)(instList, iter)) {
+                    rule._hits++;
+                    matched = true;
+                    break;
+                }
+            }
+            if (matched) {
+                changed = true;
+                // the previous instruction may match with its new neighbour
+                if (iter != instList.begin()) {
+                    iter--;
+                }
+            } else {
+                iter++;
+            }
+        }
+    }
+    return changed;
+}
+
+void PeepholeOptimizer::printStatistics(std::ostream& os) {
+    os << "===-------------------------------------------------------------------------===" << std::endl;
+    os << "                          ... Peephole statistics ..." << std::endl;
+    os << "===-------------------------------------------------------------------------===" << std::endl;
+    for (auto& rule : Rules) {
+        os << "  " << rule._hits << "\t" << rule._name << std::endl;
+        rule._hits = 0;
+    }
+}
+
+// mv a, a
+bool PeepholeOptimizer::removeSelfMove(std::list<Instruction*>& instList, InstIter& iter) {
+    auto inst = *iter;
+    if (!isMove(inst) || inst->getDest()->getName() != inst->getSrc1()->getName()) {
+        return false;
+    }
+    eraseInst(instList, iter);
+    return true;
+}
+
+// addi a, b, 0 -> mv a, b
+bool PeepholeOptimizer::zeroImmToMove(std::list<Instruction*>&, InstIter& iter) {
+    auto inst = *iter;
+    if (inst->getClassId() != ID_BINARY_INST || inst->getSrc2() || inst->getImm() != 0) {
+        return false;
+    }
+    switch (inst->getInstType()) {
+        case BinaryInst::INST_ADDI:
+        case BinaryInst::INST_XORI:
+        case BinaryInst::INST_SLLI:
+        case BinaryInst::INST_SRAI:
+            replaceInst(iter, new UnaryInst(UnaryInst::INST_MV, inst->getDest(), inst->getSrc1()));
+            return true;
+        default:
+            // the w instructions sign-extend the low word, they aren't moves
+            return false;
+    }
+}
+
+// sw a, imm(b); lw c, imm(b) -> sw a, imm(b); sext.w c, a
+bool PeepholeOptimizer::forwardStoreToLoad(std::list<Instruction*>& instList, InstIter& iter) {
+    auto store = *iter;
+    auto nextIter = std::next(iter);
+    if (store->getClassId() != ID_STORE_INST || nextIter == instList.end()) {
+        return false;
+    }
+    auto load = *nextIter;
+    if (load->getClassId() != ID_LOAD_INST || load->getImm() != store->getImm() ||
+        load->getSrc1()->getName() != store->getSrc2()->getName()) {
+        return false;
+    }
+
+    Instruction* replacement;
+    auto value = store->getSrc1();
+    switch (store->getInstType() * 16 + load->getInstType()) {
+        case StoreInst::INST_SW * 16 + LoadInst::INST_LW:
+            replacement = new BinaryInst(BinaryInst::INST_ADDIW, load->getDest(), value, 0);
+            break;
+        case StoreInst::INST_SD * 16 + LoadInst::INST_LD:
+            replacement = new UnaryInst(UnaryInst::INST_MV, load->getDest(), value);
+            break;
+        case StoreInst::INST_FSW * 16 + LoadInst::INST_FLW:
+        case StoreInst::INST_FSD * 16 + LoadInst::INST_FLD:
+            replacement = new UnaryInst(UnaryInst::INST_FMV_S, load->getDest(), value);
+            break;
+        default:
+            return false;
+    }
+    replaceInst(nextIter, replacement);
+    return true;
+}
+
+// li a, 0; ... b, a -> ... b, zero
+bool PeepholeOptimizer::useZeroReg(std::list<Instruction*>& instList, InstIter& iter) {
+    auto li = *iter;
+    if (li->getClassId() != ID_IMM_INST || li->getInstType() != ImmInst::INST_LI || li->getImm() != 0 ||
+        li->getDest()->isFixed() || getDef(li->getDest()) != li) {
+        return false;
+    }
+    auto reg = li->getDest();
+    bool changed = false;
+    for (auto useIter = std::next(iter); useIter != instList.end(); useIter++) {
+        auto inst = *useIter;
+        if (inst->getSrc1() == reg || inst->getSrc2() == reg) {
+            replaceSrc(inst, reg, Register::Zero);
+            changed = true;
+        }
+    }
+    // used by the other blocks
+    if (_useCount[reg] > 0) {
+        return changed;
+    }
+    eraseInst(instList, iter);
+    return true;
+}
+
+// the compare results are 0 or 1, so snez a, b -> mv a, b and the double negations are moves
+bool PeepholeOptimizer::foldBoolChain(std::list<Instruction*>&, InstIter& iter) {
+    auto inst = *iter;
+    auto type = inst->getInstType();
+    Register* result = nullptr;
+    if (inst->getClassId() == ID_UNARY_INST && type == UnaryInst::INST_SNEZ) {
+        if (isBool(inst->getSrc1())) {
+            result = inst->getSrc1();
+        }
+    } else if ((inst->getClassId() == ID_UNARY_INST && type == UnaryInst::INST_SEQZ) ||
+               (inst->getClassId() == ID_BINARY_INST && type == BinaryInst::INST_XORI && inst->getImm() == 1)) {
+        auto def = getDef(getCopySource(inst->getSrc1()));
+        if (def && ((def->getClassId() == ID_UNARY_INST && def->getInstType() == UnaryInst::INST_SEQZ) ||
+                    (def->getClassId() == ID_BINARY_INST && def->getInstType() == BinaryInst::INST_XORI &&
+                     def->getImm() == 1))) {
+            if (isBool(def->getSrc1())) {
+                result = def->getSrc1();
+            }
+        }
+    }
+    if (!result) {
+        return false;
+    }
+    replaceInst(iter, new UnaryInst(UnaryInst::INST_MV, inst->getDest(), result));
+    return true;
+}
+
+bool PeepholeOptimizer::removeDeadDef(std::list<Instruction*>& instList, InstIter& iter) {
+    auto inst = *iter;
+    switch (inst->getClassId()) {
+        case ID_IMM_INST:
+        case ID_LOAD_GLOBAL_ADDR_INST:
+        case ID_LOAD_INST:
+        case ID_UNARY_INST:
+        case ID_BINARY_INST:
+            break;
+        default:
+            return false;
+    }
+    auto dest = inst->getDest();
+    if (dest->isFixed() || _useCount[dest] > 0) {
+        return false;
+    }
+    eraseInst(instList, iter);
+    return true;
+}
+
+void PeepholeOptimizer::buildDefUse() {
+    _useCount.clear();
+    _defs.clear();
+    for (auto bb : _theFunction->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            addUses(inst, 1);
+            if (auto dest = inst->getDest()) {
+                auto ret = _defs.insert({dest, inst});
+                if (!ret.second) {
+                    ret.first->second = nullptr;
+                }
+            }
+        }
+    }
+}
+
+void PeepholeOptimizer::addUses(Instruction* inst, int delta) {
+    if (_isAllocated) {
+        return;
+    }
+    if (auto src1 = inst->getSrc1()) {
+        _useCount[src1] += delta;
+    }
+    if (auto src2 = inst->getSrc2()) {
+        _useCount[src2] += delta;
+    }
+}
+
+void PeepholeOptimizer::replaceInst(InstIter& iter, Instruction* inst) {
+    auto old = *iter;
+    assert(old->getDest() == inst->getDest());
+    addUses(old, -1);
+    addUses(inst, 1);
+    if (!_isAllocated && _defs[inst->getDest()] == old) {
+        _defs[inst->getDest()] = inst;
+    }
+    *iter = inst;
+}
+
+void PeepholeOptimizer::eraseInst(std::list<Instruction*>& instList, InstIter& iter) {
+    addUses(*iter, -1);
+    iter = instList.erase(iter);
+}
+
+void PeepholeOptimizer::replaceSrc(Instruction* inst, Register* from, Register* to) {
+    addUses(inst, -1);
+    if (inst->getSrc1() == from) {
+        inst->setSrc1(to);
+    }
+    if (inst->getSrc2() == from) {
+        inst->setSrc2(to);
+    }
+    addUses(inst, 1);
+}
+
+Instruction* PeepholeOptimizer::getDef(Register* reg) {
+    if (reg->isFixed()) {
+        return nullptr;
+    }
+    auto iter = _defs.find(reg);
+    return iter != _defs.end() ? iter->second : nullptr;
+}
+
+Register* PeepholeOptimizer::getCopySource(Register* reg) {
+    auto def = getDef(reg);
+    // the copies of phis may form a cycle
+    for (int i = 0; i < MaxChainLength && def && isMove(def); i++) {
+        reg = def->getSrc1();
+        def = getDef(reg);
+    }
+    return reg;
+}
+
+bool PeepholeOptimizer::isBool(Register* reg, int depth) {
+    if (reg == Register::Zero) {
+        return true;
+    }
+    if (depth > MaxChainLength) {
+        return false;
+    }
+    auto def = getDef(getCopySource(reg));
+    if (!def) {
+        return false;
+    }
+    auto type = def->getInstType();
+    if (def->getClassId() == ID_UNARY_INST) {
+        return type == UnaryInst::INST_SEQZ || type == UnaryInst::INST_SNEZ;
+    }
+    if (def->getClassId() == ID_BINARY_INST) {
+        switch (type) {
+            case BinaryInst::INST_SLT:
+            case BinaryInst::INST_SLTI:
+            case BinaryInst::INST_FLT_S:
+            case BinaryInst::INST_FLE_S:
+            case BinaryInst::INST_FEQ_S:
+                return true;
+            case BinaryInst::INST_XORI:
+                return def->getImm() == 1 && isBool(def->getSrc1(), depth + 1);
+            default:
+                return false;
+        }
+    }
+    if (def->getClassId() == ID_IMM_INST) {
+        return type == ImmInst::INST_LI && (def->getImm() == 0 || def->getImm() == 1);
+    }
+    return false;
+}
+
+bool PeepholeOptimizer::isMove(Instruction* inst) {
+    return inst->getClassId() == ID_UNARY_INST &&
+           (inst->getInstType() == UnaryInst::INST_MV || inst->getInstType() == UnaryInst::INST_FMV_S);
+}
+
+}  // namespace RISCV
+}  // namespace ATC
@@ -1,204 +1,630 @@
 #include "riscv/RegAllocator.h"
 
+#include <algorithm>
+#include <climits>
+#include <unordered_map>
+
+#include "../DataFlow.h"
+
 namespace ATC {
 
 namespace RISCV {
 
+// the id of a phy reg is its position, the int regs come first
+// clang-format off
+static const std::vector<std::string> PhyRegs = {
+    "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7",
+    "t0", "t1", "t2", "t3", "t4", "t5", "t6",
+    "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9", "s10", "s11",
+
+    "fa0", "fa1", "fa2", "fa3", "fa4", "fa5", "fa6", "fa7",
+    "ft0", "ft1", "ft2", "ft3", "ft4", "ft5", "ft6", "ft7", "ft8", "ft9", "ft10", "ft11",
+    "fs0", "fs1", "fs2", "fs3", "fs4", "fs5", "fs6", "fs7", "fs8", "fs9", "fs10", "fs11"
+};
+static const std::set<std::string> CalleeSavePhyRegs = {
+    "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9", "s10", "s11",
+    "fs0", "fs1", "fs2", "fs3", "fs4", "fs5", "fs6", "fs7", "fs8", "fs9", "fs10", "fs11"
+};
+// clang-format on
+static const int IntPhyRegNum = 26;
+static const int PhyRegNum = 58;
+static_assert(PhyRegNum <= 64, "the used phy regs are kept in a uint64_t");
+
+// -1 if the reg can't be allocated, such as sp
+static int getPhyRegId(const std::string& name) {
+    static const std::unordered_map<std::string, int> name2id = [] {
+        std::unordered_map<std::string, int> name2id;
+        for (int i = 0; i < PhyRegNum; i++) {
+            name2id[PhyRegs[i]] = i;
+        }
+        return name2id;
+    }();
+    auto iter = name2id.find(name);
+    return iter == name2id.end() ? -1 : iter->second;
+}
+
+// the ids of the phy regs which can be allocated to the int or float reg are in [begin, end)
+static int getPhyRegBegin(bool isInt) { return isInt ? 0 : IntPhyRegNum; }
+static int getPhyRegEnd(bool isInt) { return isInt ? IntPhyRegNum : PhyRegNum; }
+static int getColorNum(bool isInt) { return getPhyRegEnd(isInt) - getPhyRegBegin(isInt); }
+
+static bool isMove(Instruction* inst) {
+    return inst->getClassId() == ID_UNARY_INST &&
+           (inst->getInstType() == UnaryInst::INST_MV || inst->getInstType() == UnaryInst::INST_FMV_S);
+}
+
 void RegAllocator::run() {
     while (true) {
-        // coalescing();
-        buildInterference();
-        if (!coloring()) {
-            reset();
-            spill();
+        bool success;
+        if (_useGraphColoring) {
+            buildInterference();
+            coalescing();
+            success = coloring();
         } else {
+            buildLiveness();
+            buildIntervals();
+            success = linearScan();
+        }
+        if (success) {
             break;
         }
+        reset();
+        spill();
     }
 }
 
 void RegAllocator::buildInterference() {
-    bool update;
-    do {
-        update = false;
-        for (auto bb : _theFunction->getBasicBlocks()) {
-            std::set<Register*> alives;
-            for (auto succ : bb->getSuccessors()) {
-                alives.insert(succ->getAlives().begin(), succ->getAlives().end());
-            }
-
-            for (auto rbegin = bb->getInstructionList().rbegin(); rbegin != bb->getInstructionList().rend(); rbegin++) {
-                auto inst = *rbegin;
-                if (Register* dest = inst->getDest()) {
-                    if (!dest->isFixed()) {
-                        _theFunction->addNeedAllocReg(dest);
-                    }
-                    alives.erase(dest);
-                }
+    buildLiveness();
 
-                if (Register* src1 = inst->getSrc1()) {
-                    for (auto reg : alives) {
-                        if (reg == src1 || reg->isIntReg() != src1->isIntReg()) {
-                            continue;
-                        }
-                        if (!src1->isFixed()) {
-                            src1->addInterference(reg);
-                        }
-                        if (!reg->isFixed()) {
-                            reg->addInterference(src1);
-                        }
-                    }
-                    if (!src1->isFixed()) {
-                        _theFunction->addNeedAllocReg(src1);
-                    }
-                    alives.insert(src1);
-                }
+    // the phy regs are the first nodes, then the virtual regs
+    _reg2node.assign(_regs.size(), -1);
+    _nodeRegs.assign(PhyRegNum, nullptr);
+    for (size_t i = 0; i < _regs.size(); i++) {
+        auto reg = _regs[i];
+        if (reg->isFixed()) {
+            int id = getPhyRegId(reg->getName());
+            _reg2node[i] = id;
+            if (id >= 0 && !_nodeRegs[id]) {
+                _nodeRegs[id] = reg;
+            }
+        } else {
+            _reg2node[i] = _nodeRegs.size();
+            _nodeRegs.push_back(reg);
+            _theFunction->addNeedAllocReg(reg);
+        }
+    }
+    _graph = InterferenceGraph(_nodeRegs.size(), PhyRegNum);
+    _aliases.assign(_nodeRegs.size(), -1);
 
-                if (Register* src2 = inst->getSrc2()) {
-                    for (auto reg : alives) {
-                        if (reg == src2 || reg->isIntReg() != src2->isIntReg()) {
-                            continue;
-                        }
-                        if (!src2->isFixed()) {
-                            src2->addInterference(reg);
-                        }
-                        if (!reg->isFixed()) {
-                            reg->addInterference(src2);
-                        }
+    std::vector<int> callerSavedNodes;
+    for (auto saved : Function::CallerSavedRegs) {
+        callerSavedNodes.push_back(getPhyRegId(saved->getName()));
+    }
+
+    // the reg is defined or used here, it can't share the phy reg with the values alive after the inst
+    auto addInterferences = [&](Register* reg, const BitVector& alives) {
+        int node = getNode(reg);
+        if (node < 0) {
+            return;
+        }
+        alives.forEach([&](int index) {
+            int alive = _reg2node[index];
+            if (alive >= 0 && alive != node && _regs[index]->isIntReg() == reg->isIntReg()) {
+                _graph.addEdge(node, alive);
+            }
+        });
+    };
+
+    for (auto bb : _theFunction->getBasicBlocks()) {
+        BitVector alives = _liveOuts[bb];
+        for (auto rbegin = bb->getInstructionList().rbegin(); rbegin != bb->getInstructionList().rend(); rbegin++) {
+            auto inst = *rbegin;
+            if (Register* dest = inst->getDest()) {
+                addInterferences(dest, alives);
+                alives.reset(_reg2index[dest]);
+            }
+            if (Register* src1 = inst->getSrc1()) {
+                addInterferences(src1, alives);
+                alives.set(_reg2index[src1]);
+            }
+            if (Register* src2 = inst->getSrc2()) {
+                addInterferences(src2, alives);
+                alives.set(_reg2index[src2]);
+            }
+            if (inst->getClassId() == ID_FUNCTION_CALL_INST) {
+                alives.forEach([&](int index) {
+                    int alive = _reg2node[index];
+                    if (alive < PhyRegNum) {
+                        return;
                     }
-                    if (!src2->isFixed()) {
-                        _theFunction->addNeedAllocReg(src2);
+                    for (auto saved : callerSavedNodes) {
+                        if (saved >= 0 && isIntNode(saved) == _regs[index]->isIntReg()) {
+                            _graph.addEdge(alive, saved);
+                        }
                     }
-                    alives.insert(src2);
+                });
+                // these reg across the function call
+                for (auto usedReg : ((FunctionCallInst*)inst)->getUsedRges()) {
+                    alives.set(_reg2index[usedReg]);
                 }
+            }
+        }
+    }
+}
 
-                if (inst->getClassId() == ID_FUNCTION_CALL_INST) {
-                    for (auto saved : Function::CallerSavedRegs) {
-                        for (auto reg : alives) {
-                            if (reg == saved || reg->isIntReg() != saved->isIntReg() || reg->isFixed()) {
-                                continue;
-                            }
-                            reg->addInterference(saved);
-                        }
-                    }
-                    FunctionCallInst* call = (FunctionCallInst*)inst;
-                    // these reg across the function call
-                    for (auto usedReg : call->getUsedRges()) {
-                        alives.insert(usedReg);
+void RegAllocator::coalescing() {
+    std::vector<Instruction*> moves;
+    for (auto bb : _theFunction->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            if (isMove(inst)) {
+                moves.push_back(inst);
+            }
+        }
+    }
+
+    auto getAlias = [&](int node) {
+        while (_aliases[node] >= 0) {
+            node = _aliases[node];
+        }
+        return node;
+    };
+    auto isSignificant = [&](int node) {
+        return _graph.isPrecolored(node) || _graph.getDegree(node) >= getColorNum(isIntNode(node));
+    };
+
+    bool changed;
+    do {
+        changed = false;
+        for (auto& move : moves) {
+            if (!move) {
+                continue;
+            }
+            int u = getNode(move->getDest());
+            int v = getNode(move->getSrc1());
+            if (u < 0 || v < 0 || (u = getAlias(u)) == (v = getAlias(v))) {
+                move = nullptr;
+                continue;
+            }
+            if (_graph.isPrecolored(v)) {
+                std::swap(u, v);
+            }
+            // the short-lived regs created by spilling keep their own nodes, so they are never spilled again
+            if (_graph.isPrecolored(v) ||
+                (!_graph.isPrecolored(u) && (_nodeRegs[u]->isSpilled() || _nodeRegs[v]->isSpilled())) ||
+                _graph.hasEdge(u, v)) {
+                continue;
+            }
+
+            bool canCoalesce = true;
+            if (_graph.isPrecolored(u)) {
+                // George: every neighbour of v already interferes with u or is of low degree
+                for (auto neighbour : _graph.getNeighbours(v)) {
+                    if (!_graph.isPrecolored(neighbour) && isSignificant(neighbour) && !_graph.hasEdge(neighbour, u)) {
+                        canCoalesce = false;
+                        break;
                     }
                 }
+            } else {
+                // Briggs: the merged node has less than K neighbours of significant degree
+                int significant = 0;
+                for (auto neighbour : _graph.getNeighbours(u)) {
+                    significant += isSignificant(neighbour);
+                }
+                for (auto neighbour : _graph.getNeighbours(v)) {
+                    significant += !_graph.hasEdge(neighbour, u) && isSignificant(neighbour);
+                }
+                canCoalesce = significant < getColorNum(isIntNode(u));
             }
-            if (bb->getAlives() != alives) {
-                update = true;
-                bb->setAlives(alives);
+            if (!canCoalesce) {
+                continue;
             }
+
+            _graph.merge(v, u);
+            _aliases[v] = u;
+            _theFunction->getNeedAllocRegs().erase(_nodeRegs[v]);
+            move = nullptr;
+            changed = true;
         }
-    } while (update);
+    } while (changed);
+
+    auto getAliasReg = [&](Register* reg) {
+        int node = getNode(reg);
+        return node < 0 ? reg : _nodeRegs[getAlias(node)];
+    };
+    for (auto bb : _theFunction->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            if (inst->getDest()) {
+                inst->setDest(getAliasReg(inst->getDest()));
+            }
+            if (inst->getSrc1()) {
+                inst->setSrc1(getAliasReg(inst->getSrc1()));
+            }
+            if (inst->getSrc2()) {
+                inst->setSrc2(getAliasReg(inst->getSrc2()));
+            }
+        }
+    }
 }
 
 bool RegAllocator::coloring() {
-    // clang-format off
-    std::vector<std::string> intPhyReg = {
-        "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7", 
-        "t0", "t1", "t2", "t3", "t4", "t5", "t6",
-        "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9", "s10", "s11"
-    };
-    std::vector<std::string> floatPhyReg = {
-        "fa0", "fa1", "fa2", "fa3", "fa4", "fa5", "fa6", "fa7",  
-        "ft0", "ft1", "ft2", "ft3", "ft4", "ft5", "ft6", "ft7", "ft8", "ft9", "ft10", "ft11",
-        "fs0", "fs1", "fs2", "fs3", "fs4", "fs5", "fs6", "fs7", "fs8", "fs9", "fs10", "fs11"
-    };
+    // the virtual nodes not merged by coalescing
+    std::vector<int> nodes;
+    for (int node = PhyRegNum; node < _graph.size(); node++) {
+        if (_aliases[node] < 0) {
+            nodes.push_back(node);
+        }
+    }
 
-    std::set<std::string> calleeSavePhyReg = {
-        "s1", "s2", "s3", "s4", "s5", "s6", "s7", "s8", "s9", "s10", "s11", 
-        "fs0", "fs1", "fs2", "fs3", "fs4", "fs5", "fs6", "fs7", "fs8", "fs9", "fs10", "fs11"
-    };
-    // clang-format on
-
-    auto colorOneReg = [&](Register* reg, const std::vector<std::string>& phyRegs) {
-        for (auto phyReg : phyRegs) {
-            bool conflict = false;
-            for (auto interference : reg->getInterferences()) {
-                if (interference->getName() == phyReg) {
-                    conflict = true;
-                    break;
+    // the spill cost is the number of defs and uses weighted by 10 ^ loop depth
+    std::vector<double> costs(_graph.size(), 0);
+    for (auto bb : _theFunction->getBasicBlocks()) {
+        double weight = 1;
+        for (int i = 0; i < bb->getLoopDepth(); i++) {
+            weight *= 10;
+        }
+        for (auto inst : bb->getInstructionList()) {
+            for (auto reg : {inst->getDest(), inst->getSrc1(), inst->getSrc2()}) {
+                if (reg && !reg->isFixed()) {
+                    costs[getNode(reg)] += weight;
                 }
             }
-            if (!conflict) {
-                reg->setName(phyReg);
-                if (calleeSavePhyReg.find(phyReg) != calleeSavePhyReg.end()) {
-                    for (auto calleeSaveReg : Function::CalleeSavedRegs) {
-                        if (calleeSaveReg->getName() == phyReg) {
-                            _theFunction->addNeedPushReg(calleeSaveReg);
-                            break;
-                        }
-                    }
-                }
-                return true;
+        }
+    }
+
+    // simplify: remove the nodes of degree < K, when all the left ones are of degree >= K, remove the one of the
+    // lowest cost / degree optimistically, it may still get a color in select
+    std::vector<int> degrees(_graph.size(), 0);
+    std::vector<bool> inGraph(_graph.size(), false);
+    std::vector<int> lowDegrees;
+    std::vector<int> stack;
+    for (auto node : nodes) {
+        degrees[node] = _graph.getDegree(node);
+        inGraph[node] = true;
+        if (degrees[node] < getColorNum(isIntNode(node))) {
+            lowDegrees.push_back(node);
+        }
+    }
+    auto remove = [&](int node) {
+        inGraph[node] = false;
+        stack.push_back(node);
+        for (auto neighbour : _graph.getNeighbours(node)) {
+            if (inGraph[neighbour] && degrees[neighbour]-- == getColorNum(isIntNode(neighbour))) {
+                lowDegrees.push_back(neighbour);
             }
         }
-        return false;
     };
+    while (stack.size() < nodes.size()) {
+        if (!lowDegrees.empty()) {
+            int node = lowDegrees.back();
+            lowDegrees.pop_back();
+            if (inGraph[node]) {
+                remove(node);
+            }
+            continue;
+        }
+        // the short-lived regs created by spilling are never chosen, so they are never spilled again
+        int candidate = -1;
+        for (auto node : nodes) {
+            if (!inGraph[node] || (_nodeRegs[node]->isSpilled() && candidate >= 0)) {
+                continue;
+            }
+            if (candidate < 0 || (_nodeRegs[candidate]->isSpilled() && !_nodeRegs[node]->isSpilled()) ||
+                costs[node] / degrees[node] < costs[candidate] / degrees[candidate]) {
+                candidate = node;
+            }
+        }
+        remove(candidate);
+    }
 
-    for (auto reg : _theFunction->getNeedAllocRegs()) {
-        bool success;
-        if (reg->isIntReg()) {
-            success = colorOneReg(reg, intPhyReg);
-        } else {
-            success = colorOneReg(reg, floatPhyReg);
+    // select: the phy reg is its own color
+    std::vector<int> colors(_graph.size(), -1);
+    for (int id = 0; id < PhyRegNum; id++) {
+        colors[id] = id;
+    }
+    while (!stack.empty()) {
+        int node = stack.back();
+        stack.pop_back();
+        uint64_t used = 0;
+        for (auto neighbour : _graph.getNeighbours(node)) {
+            if (colors[neighbour] >= 0) {
+                used |= (uint64_t)1 << colors[neighbour];
+            }
         }
-        if (!success) {
-            _needSpill = reg;
-            return false;
+        bool isInt = isIntNode(node);
+        for (int id = getPhyRegBegin(isInt); id < getPhyRegEnd(isInt); id++) {
+            if (!(used & ((uint64_t)1 << id))) {
+                colors[node] = id;
+                break;
+            }
+        }
+        if (colors[node] >= 0) {
+            setPhyReg(_nodeRegs[node], colors[node]);
+        } else {
+            // all the regs failed to color are spilled together
+            _needSpills.push_back(_nodeRegs[node]);
         }
     }
-    return true;
+    return _needSpills.empty();
 }
 
-void RegAllocator::spill() {
-    std::list<Instruction*>::iterator spillPos;
+void RegAllocator::buildLiveness() {
+    _regs.clear();
+    _reg2index.clear();
+    _liveOuts.clear();
+    auto number = [&](Register* reg) {
+        if (reg && _reg2index.insert({reg, _regs.size()}).second) {
+            _regs.push_back(reg);
+        }
+    };
     for (auto bb : _theFunction->getBasicBlocks()) {
-        std::vector<std::list<Instruction*>::iterator> reloadPos;
-        auto& instList = bb->getMutableInstructionList();
-        spillPos = instList.end();
-        for (auto begin = instList.begin(); begin != instList.end(); begin++) {
-            auto inst = *begin;
-            if (inst->getDest() == _needSpill) {
-                _currentOffset -= 8;
-                spillPos = begin;
+        for (auto inst : bb->getInstructionList()) {
+            number(inst->getDest());
+            number(inst->getSrc1());
+            number(inst->getSrc2());
+            if (inst->getClassId() == ID_FUNCTION_CALL_INST) {
+                for (auto usedReg : ((FunctionCallInst*)inst)->getUsedRges()) {
+                    number(usedReg);
+                }
             }
+        }
+    }
 
-            if (inst->getSrc1() == _needSpill || inst->getSrc2() == _needSpill) {
-                reloadPos.push_back(begin);
+    // the blocks are laid out in reverse post order of the IR
+    std::vector<BasicBlock*> blocks(_theFunction->getBasicBlocks().begin(), _theFunction->getBasicBlocks().end());
+    BackwardDataFlow<BasicBlock> liveness(blocks, _regs.size());
+    for (size_t i = 0; i < blocks.size(); i++) {
+        BitVector gen(_regs.size());
+        BitVector kill(_regs.size());
+        auto& instList = blocks[i]->getInstructionList();
+        for (auto rbegin = instList.rbegin(); rbegin != instList.rend(); rbegin++) {
+            auto inst = *rbegin;
+            if (Register* dest = inst->getDest()) {
+                kill.set(_reg2index[dest]);
+                gen.reset(_reg2index[dest]);
+            }
+            if (Register* src1 = inst->getSrc1()) {
+                gen.set(_reg2index[src1]);
+            }
+            if (Register* src2 = inst->getSrc2()) {
+                gen.set(_reg2index[src2]);
+            }
+            if (inst->getClassId() == ID_FUNCTION_CALL_INST) {
+                for (auto usedReg : ((FunctionCallInst*)inst)->getUsedRges()) {
+                    gen.set(_reg2index[usedReg]);
+                }
             }
         }
-        if (spillPos != instList.end()) {
-            if (_needSpill->isIntReg()) {
-                /// FIXME:_currentOffset may exceed the immediate number range
-                instList.insert(++spillPos,
-                                new StoreInst(StoreInst::INST_SD, _needSpill, Register::S0, _currentOffset));
-            } else {
-                instList.insert(++spillPos,
-                                new StoreInst(StoreInst::INST_FSD, _needSpill, Register::S0, _currentOffset));
+        liveness.setGenKill(i, std::move(gen), std::move(kill));
+    }
+    liveness.solve();
+    for (size_t i = 0; i < blocks.size(); i++) {
+        _liveOuts[blocks[i]] = liveness.getOut(i);
+    }
+}
+
+void RegAllocator::buildIntervals() {
+    _intervals.clear();
+    _fixedRanges.assign(PhyRegNum, {});
+    std::unordered_map<Register*, int> reg2interval;
+    auto addRange = [&](Register* reg, int start, int end) {
+        if (reg->isFixed()) {
+            int id = getPhyRegId(reg->getName());
+            if (id >= 0) {
+                _fixedRanges[id].push_back({start, end});
+            }
+            return;
+        }
+        auto [iter, inserted] = reg2interval.insert({reg, _intervals.size()});
+        if (inserted) {
+            _intervals.push_back({reg, start, end});
+            _theFunction->addNeedAllocReg(reg);
+        } else {
+            auto& interval = _intervals[iter->second];
+            interval._start = std::min(interval._start, start);
+            interval._end = std::max(interval._end, end);
+        }
+    };
+
+    int index = 0;
+    for (auto bb : _theFunction->getBasicBlocks()) {
+        auto& instList = bb->getInstructionList();
+        if (instList.empty()) {
+            continue;
+        }
+        int first = index;
+        index += instList.size();
+        int n = index - 1;
+
+        // the alive reg to the end of its range in this block
+        std::unordered_map<Register*, int> alives;
+        _liveOuts[bb].forEach([&](int index) { alives[_regs[index]] = 2 * n + 1; });
+        // the later use is met first, keep its end
+        auto use = [&](Register* reg, int pos) { alives.insert({reg, pos}); };
+        for (auto rbegin = instList.rbegin(); rbegin != instList.rend(); rbegin++, n--) {
+            auto inst = *rbegin;
+            if (Register* dest = inst->getDest()) {
+                auto iter = alives.find(dest);
+                if (iter == alives.end()) {
+                    addRange(dest, 2 * n + 1, 2 * n + 1);
+                } else {
+                    addRange(dest, 2 * n + 1, iter->second);
+                    alives.erase(iter);
+                }
+            }
+            if (Register* src1 = inst->getSrc1()) {
+                use(src1, 2 * n);
+            }
+            if (Register* src2 = inst->getSrc2()) {
+                use(src2, 2 * n);
+            }
+            if (inst->getClassId() == ID_FUNCTION_CALL_INST) {
+                // the caller saved regs are clobbered by the call
+                for (auto saved : Function::CallerSavedRegs) {
+                    int id = getPhyRegId(saved->getName());
+                    if (id >= 0) {
+                        _fixedRanges[id].push_back({2 * n + 1, 2 * n + 1});
+                    }
+                }
+                for (auto usedReg : ((FunctionCallInst*)inst)->getUsedRges()) {
+                    use(usedReg, 2 * n);
+                }
             }
         }
-        for (auto pos : reloadPos) {
-            if (_needSpill->isIntReg()) {
-                instList.insert(pos, new LoadInst(LoadInst::INST_LD, _needSpill, Register::S0, _currentOffset));
+        for (auto [reg, end] : alives) {
+            addRange(reg, 2 * first, end);
+        }
+    }
+
+    std::stable_sort(_intervals.begin(), _intervals.end(),
+                     [](const Interval& lhs, const Interval& rhs) { return lhs._start < rhs._start; });
+    for (auto& ranges : _fixedRanges) {
+        std::sort(ranges.begin(), ranges.end());
+        std::vector<std::pair<int, int>> merged;
+        for (auto& range : ranges) {
+            if (!merged.empty() && range.first <= merged.back().second) {
+                merged.back().second = std::max(merged.back().second, range.second);
             } else {
-                instList.insert(pos, new LoadInst(LoadInst::INST_FLD, _needSpill, Register::S0, _currentOffset));
+                merged.push_back(range);
             }
         }
+        ranges.swap(merged);
     }
+}
+
+bool RegAllocator::linearScan() {
+    auto overlapFixed = [&](int id, int start, int end) {
+        // the ranges are disjoint, only the last one starting before end may overlap
+        auto& ranges = _fixedRanges[id];
+        auto next = std::upper_bound(ranges.begin(), ranges.end(), std::make_pair(end, INT_MAX));
+        return next != ranges.begin() && std::prev(next)->second >= start;
+    };
+
+    std::vector<Interval*> active(PhyRegNum, nullptr);  // the phy reg to the interval holding it
+    for (auto& interval : _intervals) {
+        for (auto& holder : active) {
+            if (holder && holder->_end < interval._start) {
+                holder = nullptr;
+            }
+        }
+
+        int chosen = -1;
+        Interval* victim = nullptr;
+        bool isInt = interval._reg->isIntReg();
+        for (int id = getPhyRegBegin(isInt); id < getPhyRegEnd(isInt); id++) {
+            if (overlapFixed(id, interval._start, interval._end)) {
+                continue;
+            }
+            if (!active[id]) {
+                chosen = id;
+                victim = nullptr;
+                break;
+            }
+            // the short-lived regs created by spilling are never evicted, so they are never spilled again
+            if (!active[id]->_reg->isSpilled() && (!victim || active[id]->_end > victim->_end)) {
+                chosen = id;
+                victim = active[id];
+            }
+        }
 
-    _needSpill = nullptr;
+        // evict the interval ending furthest, the spilled interval is split at its defs and uses by spillOneReg
+        if (chosen < 0 || (victim && victim->_end <= interval._end && !interval._reg->isSpilled())) {
+            _needSpills.push_back(interval._reg);
+            continue;
+        }
+        if (victim) {
+            _needSpills.push_back(victim->_reg);
+        }
+        active[chosen] = &interval;
+        setPhyReg(interval._reg, chosen);
+    }
+    return _needSpills.empty();
 }
 
-void RegAllocator::reset() {
+int RegAllocator::getNode(Register* reg) { return _reg2node[_reg2index[reg]]; }
+
+bool RegAllocator::isIntNode(int node) {
+    return node < PhyRegNum ? node < IntPhyRegNum : _nodeRegs[node]->isIntReg();
+}
+
+void RegAllocator::setPhyReg(Register* reg, int id) {
+    auto& phyReg = PhyRegs[id];
+    reg->setName(phyReg);
+    if (CalleeSavePhyRegs.find(phyReg) != CalleeSavePhyRegs.end()) {
+        for (auto calleeSaveReg : Function::CalleeSavedRegs) {
+            if (calleeSaveReg->getName() == phyReg) {
+                _theFunction->addNeedPushReg(calleeSaveReg);
+                break;
+            }
+        }
+    }
+}
+
+void RegAllocator::spill() {
+    for (auto needSpill : _needSpills) {
+        spillOneReg(needSpill);
+    }
+    _needSpills.clear();
+}
+
+void RegAllocator::spillOneReg(Register* needSpill) {
+    // all the defs and uses of the spilled reg share one stack slot
+    _currentOffset -= 8;
+    int offset = _currentOffset;
     for (auto bb : _theFunction->getBasicBlocks()) {
-        bb->reset();
+        auto& instList = bb->getMutableInstructionList();
+        auto getSlotBase = [&](std::list<Instruction*>::iterator pos, int& slotOffset) {
+            slotOffset = offset;
+            if (offset >= -2048) {
+                return Register::S0;
+            }
+            int hi20 = (unsigned)offset >> 12;
+            int lo12 = offset & 0xfff;
+            if (lo12 > 2047) {
+                lo12 -= 4096;
+                hi20 += 1;
+            }
+            auto lui = new ImmInst(ImmInst::INST_LUI, hi20);
+            instList.insert(pos, lui);
+            auto add = new BinaryInst(BinaryInst::INST_ADD, Register::S0, lui->getDest());
+            instList.insert(pos, add);
+            lui->getDest()->setSpilled();
+            add->getDest()->setSpilled();
+            slotOffset = lo12;
+            return add->getDest();
+        };
+        for (auto iter = instList.begin(); iter != instList.end(); iter++) {
+            auto inst = *iter;
+            // every use reloads the value into a new short-lived reg
+            if (inst->getSrc1() == needSpill || inst->getSrc2() == needSpill) {
+                int slotOffset;
+                Register* base = getSlotBase(iter, slotOffset);
+                Register* reload = new Register(needSpill->isIntReg());
+                reload->setSpilled();
+                int type = needSpill->isIntReg() ? LoadInst::INST_LD : LoadInst::INST_FLD;
+                instList.insert(iter, new LoadInst(type, reload, base, slotOffset));
+                if (inst->getSrc1() == needSpill) {
+                    inst->setSrc1(reload);
+                }
+                if (inst->getSrc2() == needSpill) {
+                    inst->setSrc2(reload);
+                }
+            }
+            // every def writes a new short-lived reg and stores it to the slot
+            if (inst->getDest() == needSpill) {
+                Register* def = new Register(needSpill->isIntReg());
+                def->setSpilled();
+                inst->setDest(def);
+                auto next = std::next(iter);
+                int slotOffset;
+                Register* base = getSlotBase(next, slotOffset);
+                int type = needSpill->isIntReg() ? StoreInst::INST_SD : StoreInst::INST_FSD;
+                iter = instList.insert(next, new StoreInst(type, def, base, slotOffset));
+            }
+        }
     }
+}
 
+void RegAllocator::reset() {
     for (auto reg : _theFunction->getNeedAllocRegs()) {
         reg->reset();
     }
@@ -12,7 +12,6 @@ Register::Register(bool b) {
 
 void Register::reset() {
     _name = "virtual_reg" + std::to_string(Index++);
-    _interferences.clear();
 }
 
 }  // namespace RISCV
@@ -24,6 +24,10 @@ static T getArrayElement(IndexedRef *indexedRef) {
     if (var2arrayElemnt.find(var) != var2arrayElemnt.end()) {
         return var2arrayElemnt[var][elementIndex];
     }
+    // the address of var may be reused by the next compilation unit after the ast is released
+    if (Arena *arena = Arena::getCurrent(AST_ARENA)) {
+        arena->addDestructor(var, [](void *ptr) { var2arrayElemnt.erase(static_cast<Variable *>(ptr)); });
+    }
 
     int deep = 0;
     int index = 0;
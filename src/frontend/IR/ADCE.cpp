@@ -0,0 +1,182 @@
+#include "IR/ADCE.h"
+
+namespace ATC {
+namespace IR {
+
+bool ADCE::runOnModule(Module* module) {
+    _name2function.clear();
+    _sideEffectFunctions.clear();
+    for (auto function : module->getFunctions()) {
+        _name2function[function->getName()] = function;
+    }
+    computeSideEffects(module);
+
+    bool changed = false;
+    for (auto function : module->getFunctions()) {
+        changed |= runOnFunction(function);
+    }
+    return changed;
+}
+
+void ADCE::computeSideEffects(Module* module) {
+    // assume no function has side effect at first, then propagate through the calls until nothing changes
+    bool update;
+    do {
+        update = false;
+        for (auto function : module->getFunctions()) {
+            if (_sideEffectFunctions.find(function) != _sideEffectFunctions.end()) {
+                continue;
+            }
+            if (computeSideEffect(function)) {
+                _sideEffectFunctions.insert(function);
+                update = true;
+            }
+        }
+    } while (update);
+}
+
+bool ADCE::computeSideEffect(Function* function) {
+    for (auto bb : function->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            if (inst->getClassId() == ID_STORE_INST) {
+                if (!isLocalAddr(static_cast<StoreInst*>(inst)->getDest(), function)) {
+                    return true;
+                }
+            } else if (inst->getClassId() == ID_FUNCTION_CALL_INST) {
+                auto callInst = (FunctionCallInst*)inst;
+                auto iter = _name2function.find(callInst->getFuncName());
+                if (iter == _name2function.end()) {
+                    // the library functions do io, except memset which only writes its first param
+                    if (callInst->getFuncName() != "memset" || !isLocalAddr(callInst->getOperand(0), function)) {
+                        return true;
+                    }
+                } else if (_sideEffectFunctions.find(iter->second) != _sideEffectFunctions.end()) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void ADCE::collectDeadAllocas(Function* function) {
+    _deadAllocas.clear();
+    for (auto inst : function->getBasicBlocks().front()->getInstructionList()) {
+        if (inst->getClassId() != ID_ALLOC_INST) {
+            continue;
+        }
+        bool readOrEscape = false;
+        std::vector<Value*> worklist = {inst->getResult()};
+        while (!worklist.empty() && !readOrEscape) {
+            auto addr = worklist.back();
+            worklist.pop_back();
+            for (auto user : addr->getUsers()) {
+                switch (user->getClassId()) {
+                    case ID_GET_ELEMENT_PTR_INST:
+                    case ID_BITCAST_INST:
+                        worklist.push_back(user->getResult());
+                        break;
+                    case ID_STORE_INST:
+                        readOrEscape |= static_cast<StoreInst*>(user)->getValue() == addr;
+                        break;
+                    case ID_FUNCTION_CALL_INST:
+                        readOrEscape |= static_cast<FunctionCallInst*>(user)->getFuncName() != "memset";
+                        break;
+                    default:
+                        readOrEscape = true;
+                        break;
+                }
+            }
+        }
+        if (!readOrEscape) {
+            _deadAllocas.insert(inst->getResult());
+        }
+    }
+}
+
+bool ADCE::isRoot(Instruction* inst) {
+    switch (inst->getClassId()) {
+        case ID_RETURN_INST:
+        case ID_JUMP_INST:
+        case ID_COND_JUMP_INST:
+            return true;
+        case ID_STORE_INST:
+            return _deadAllocas.find(getBaseAddr(static_cast<StoreInst*>(inst)->getDest())) == _deadAllocas.end();
+        case ID_FUNCTION_CALL_INST: {
+            auto callInst = (FunctionCallInst*)inst;
+            auto iter = _name2function.find(callInst->getFuncName());
+            if (iter != _name2function.end()) {
+                return _sideEffectFunctions.find(iter->second) != _sideEffectFunctions.end();
+            }
+            if (callInst->getFuncName() == "memset") {
+                return _deadAllocas.find(getBaseAddr(callInst->getOperand(0))) == _deadAllocas.end();
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool ADCE::runOnFunction(Function* function) {
+    collectDeadAllocas(function);
+
+    std::set<Instruction*> lives;
+    std::vector<Instruction*> worklist;
+    for (auto bb : function->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            if (isRoot(inst)) {
+                lives.insert(inst);
+                worklist.push_back(inst);
+            }
+        }
+    }
+    while (!worklist.empty()) {
+        auto inst = worklist.back();
+        worklist.pop_back();
+        for (auto operand : inst->getOperands()) {
+            auto defined = operand->getDefined();
+            if (defined && lives.insert(defined).second) {
+                worklist.push_back(defined);
+            }
+        }
+    }
+
+    // drop all the references before erasing, the dead insts may use each other
+    bool changed = false;
+    for (auto bb : function->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            if (lives.find(inst) == lives.end()) {
+                inst->dropAllReferences();
+            }
+        }
+    }
+    for (auto bb : function->getBasicBlocks()) {
+        auto& instList = bb->getInstructionList();
+        for (auto iter = instList.begin(); iter != instList.end();) {
+            auto inst = *iter;
+            if (lives.find(inst) == lives.end()) {
+                iter = instList.erase(iter);
+                changed = true;
+            } else {
+                inst->setIsDead(false);
+                iter++;
+            }
+        }
+    }
+
+    changed |= function->removeUnreachableBB();
+    return changed;
+}
+
+bool ADCE::isLocalAddr(Value* addr, Function* function) {
+    auto defined = getBaseAddr(addr)->getDefined();
+    if (!defined || defined->getClassId() != ID_ALLOC_INST) {
+        return false;
+    }
+    auto& entryInsts = function->getBasicBlocks().front()->getInstructionList();
+    return std::find(entryInsts.begin(), entryInsts.end(), defined) != entryInsts.end();
+}
+
+}  // namespace IR
+}  // namespace ATC
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "IR/Function.h"
 
 namespace ATC {
@@ -8,6 +10,36 @@ BasicBlock::BasicBlock(Function* parent, const std::string& name) : _parent(pare
     parent->insertName(this);
 }
 
+void BasicBlock::addPredecessor(BasicBlock* bb) {
+    _predecessors.push_back(bb);
+    _parent->invalidateCFGAnalysis();
+}
+
+void BasicBlock::addSuccessor(BasicBlock* bb) {
+    _successors.push_back(bb);
+    _parent->invalidateCFGAnalysis();
+}
+
+void BasicBlock::removePredecessor(BasicBlock* bb) {
+    _predecessors.erase(std::remove(_predecessors.begin(), _predecessors.end(), bb), _predecessors.end());
+    _parent->invalidateCFGAnalysis();
+}
+
+void BasicBlock::removeSuccessor(BasicBlock* bb) {
+    _successors.erase(std::remove(_successors.begin(), _successors.end(), bb), _successors.end());
+    _parent->invalidateCFGAnalysis();
+}
+
+void BasicBlock::replacePredecessor(BasicBlock* from, BasicBlock* to) {
+    std::replace(_predecessors.begin(), _predecessors.end(), from, to);
+    _parent->invalidateCFGAnalysis();
+}
+
+void BasicBlock::replaceSuccessor(BasicBlock* from, BasicBlock* to) {
+    std::replace(_successors.begin(), _successors.end(), from, to);
+    _parent->invalidateCFGAnalysis();
+}
+
 void BasicBlock::addInstruction(Instruction* inst) { _instructions.push_back(inst); }
 
 std::string BasicBlock::getBBStr() { return _parent->getUniqueNameInFunction(this); }
@@ -0,0 +1,61 @@
+#include "IR/BreakCriticalEdges.h"
+
+#include <assert.h>
+
+namespace ATC {
+namespace IR {
+
+bool BreakCriticalEdges::runOnFunction(Function* function) {
+    bool changed = false;
+    std::vector<BasicBlock*> basicBlocks = function->getBasicBlocks();
+    for (auto bb : basicBlocks) {
+        auto& instList = bb->getInstructionList();
+        if (instList.empty() || instList.front()->getClassId() != ID_PHI_INST) {
+            continue;
+        }
+        std::set<BasicBlock*> preds(bb->getPredecessors().begin(), bb->getPredecessors().end());
+        for (auto pred : preds) {
+            if (pred->getSuccessors().size() < 2) {
+                continue;
+            }
+            splitEdge(pred, bb);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+BasicBlock* BreakCriticalEdges::splitEdge(BasicBlock* from, BasicBlock* to) {
+    auto splitBB = new BasicBlock(from->getParent(), "splitEdgeBB");
+    splitBB->addInstruction(new JumpInst(to));
+    splitBB->setHasBr();
+
+    auto terminator = from->getInstructionList().back();
+    if (terminator->getClassId() == ID_JUMP_INST) {
+        static_cast<JumpInst*>(terminator)->setTargetBB(splitBB);
+    } else {
+        assert(terminator->getClassId() == ID_COND_JUMP_INST && "should be the terminator");
+        auto condJumpInst = (CondJumpInst*)terminator;
+        if (condJumpInst->getTureBB() == to) {
+            condJumpInst->setTrueBB(splitBB);
+        }
+        if (condJumpInst->getFalseBB() == to) {
+            condJumpInst->setFalseBB(splitBB);
+        }
+    }
+    from->replaceSuccessor(to, splitBB);
+    splitBB->addPredecessor(from);
+    splitBB->addSuccessor(to);
+    to->replacePredecessor(from, splitBB);
+
+    for (auto inst : to->getInstructionList()) {
+        if (inst->getClassId() != ID_PHI_INST) {
+            break;
+        }
+        static_cast<PhiInst*>(inst)->replaceIncomingBB(from, splitBB);
+    }
+    return splitBB;
+}
+
+}  // namespace IR
+}  // namespace ATC
@@ -0,0 +1,72 @@
+#include "IR/CallGraph.h"
+
+#include <algorithm>
+
+namespace ATC {
+namespace IR {
+
+CallGraph::CallGraph(Module* module) {
+    for (auto function : module->getFunctions()) {
+        _name2function[function->getName()] = function;
+    }
+    for (auto function : module->getFunctions()) {
+        for (auto bb : function->getBasicBlocks()) {
+            for (auto inst : bb->getInstructionList()) {
+                if (inst->getClassId() != ID_FUNCTION_CALL_INST) {
+                    continue;
+                }
+                auto callInst = (FunctionCallInst*)inst;
+                auto callee = getFunction(callInst->getFuncName());
+                if (!callee) {
+                    continue;
+                }
+                _callSites[function].push_back(callInst);
+                _callees[function].insert(callee);
+                _callers[callee].insert(function);
+            }
+        }
+    }
+    for (auto function : module->getFunctions()) {
+        if (_indexes.find(function) == _indexes.end()) {
+            visit(function);
+        }
+    }
+}
+
+Function* CallGraph::getFunction(const std::string& name) {
+    auto iter = _name2function.find(name);
+    return iter == _name2function.end() ? nullptr : iter->second;
+}
+
+void CallGraph::visit(Function* function) {
+    _indexes[function] = _lowLinks[function] = _index++;
+    _stack.push_back(function);
+    _onStack.insert(function);
+    for (auto callee : getCallees(function)) {
+        if (_indexes.find(callee) == _indexes.end()) {
+            visit(callee);
+            _lowLinks[function] = std::min(_lowLinks[function], _lowLinks[callee]);
+        } else if (_onStack.find(callee) != _onStack.end()) {
+            _lowLinks[function] = std::min(_lowLinks[function], _indexes[callee]);
+        }
+    }
+    if (_lowLinks[function] != _indexes[function]) {
+        return;
+    }
+
+    std::vector<Function*> component;
+    Function* member;
+    do {
+        member = _stack.back();
+        _stack.pop_back();
+        _onStack.erase(member);
+        component.push_back(member);
+    } while (member != function);
+    if (component.size() > 1 || getCallees(function).count(function)) {
+        _recursiveFunctions.insert(component.begin(), component.end());
+    }
+    _bottomUpOrder.insert(_bottomUpOrder.end(), component.rbegin(), component.rend());
+}
+
+}  // namespace IR
+}  // namespace ATC
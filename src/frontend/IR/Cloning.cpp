@@ -0,0 +1,137 @@
+#include "IR/Cloning.h"
+
+#include <assert.h>
+
+#include <set>
+
+namespace ATC {
+namespace IR {
+
+Value* Cloner::getValue(Value* value) {
+    auto iter = _valueMap.find(value);
+    return iter == _valueMap.end() ? value : iter->second;
+}
+
+BasicBlock* Cloner::getBB(BasicBlock* bb) {
+    auto iter = _bbMap.find(bb);
+    return iter == _bbMap.end() ? bb : iter->second;
+}
+
+std::vector<BasicBlock*> Cloner::cloneBBs(const std::vector<BasicBlock*>& bbs) {
+    std::vector<BasicBlock*> clonedBBs;
+    for (auto bb : bbs) {
+        auto clonedBB = new BasicBlock(_function, bb->getName());
+        clonedBB->setHasBr();
+        for (auto inst : bb->getInstructionList()) {
+            auto result = inst->getResult();
+            if (result && _valueMap.find(result) != _valueMap.end()) {
+                continue;
+            }
+            auto clonedInst = inst->clone();
+            if (result) {
+                clonedInst->getResult()->setName(result->getName());
+                clonedInst->getResult()->setBelongAndInsertName(_function);
+                _valueMap[result] = clonedInst->getResult();
+            }
+            clonedBB->addInstruction(clonedInst);
+        }
+        _bbMap[bb] = clonedBB;
+        clonedBBs.push_back(clonedBB);
+    }
+
+    // the operands may be defined after the users in layout, e.g. the incomings of phi, so remap after cloning all
+    for (auto clonedBB : clonedBBs) {
+        for (auto inst : clonedBB->getInstructionList()) {
+            remapInstruction(inst);
+        }
+    }
+    return clonedBBs;
+}
+
+void Cloner::remapInstruction(Instruction* inst) {
+    for (int i = 0; i < inst->getOperandNum(); i++) {
+        inst->setOperand(i, getValue(inst->getOperand(i)));
+    }
+    switch (inst->getClassId()) {
+        case ID_JUMP_INST: {
+            auto jumpInst = (JumpInst*)inst;
+            jumpInst->setTargetBB(getBB(jumpInst->getTargetBB()));
+            break;
+        }
+        case ID_COND_JUMP_INST: {
+            auto condJumpInst = (CondJumpInst*)inst;
+            condJumpInst->setTrueBB(getBB(condJumpInst->getTureBB()));
+            condJumpInst->setFalseBB(getBB(condJumpInst->getFalseBB()));
+            break;
+        }
+        case ID_PHI_INST: {
+            auto phi = (PhiInst*)inst;
+            for (auto& [value, bb] : phi->getIncomings()) {
+                phi->replaceIncomingBB(bb, getBB(bb));
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void addSuccessorEdges(BasicBlock* bb) {
+    auto terminator = bb->getInstructionList().back();
+    std::vector<BasicBlock*> targets;
+    if (terminator->getClassId() == ID_JUMP_INST) {
+        targets.push_back(static_cast<JumpInst*>(terminator)->getTargetBB());
+    } else if (terminator->getClassId() == ID_COND_JUMP_INST) {
+        auto condJumpInst = (CondJumpInst*)terminator;
+        targets.push_back(condJumpInst->getTureBB());
+        targets.push_back(condJumpInst->getFalseBB());
+    } else {
+        assert(terminator->getClassId() == ID_RETURN_INST && "should be the terminator");
+    }
+    for (auto target : targets) {
+        bb->addSuccessor(target);
+        target->addPredecessor(bb);
+    }
+}
+
+void mergeBlocks(const std::vector<BasicBlock*>& bbs) {
+    std::set<BasicBlock*> mergeable(bbs.begin(), bbs.end());
+    for (auto bb : bbs) {
+        if (mergeable.find(bb) == mergeable.end()) {
+            continue;
+        }
+        auto& instList = bb->getInstructionList();
+        while (instList.back()->getClassId() == ID_JUMP_INST) {
+            auto target = static_cast<JumpInst*>(instList.back())->getTargetBB();
+            if (target == bb || mergeable.find(target) == mergeable.end() || target->getPredecessors().size() != 1) {
+                break;
+            }
+            instList.back()->dropAllReferences();
+            instList.pop_back();
+            for (auto inst : target->getInstructionList()) {
+                if (inst->getClassId() == ID_PHI_INST) {
+                    inst->getResult()->replaceAllUsesWith(inst->getOperand(0));
+                    inst->dropAllReferences();
+                    continue;
+                }
+                instList.push_back(inst);
+            }
+            bb->removeSuccessor(target);
+            for (auto succ : target->getSuccessors()) {
+                bb->addSuccessor(succ);
+                succ->replacePredecessor(target, bb);
+                for (auto inst : succ->getInstructionList()) {
+                    if (inst->getClassId() != ID_PHI_INST) {
+                        break;
+                    }
+                    static_cast<PhiInst*>(inst)->replaceIncomingBB(target, bb);
+                }
+            }
+            bb->getParent()->removeBB(target);
+            mergeable.erase(target);
+        }
+    }
+}
+
+}  // namespace IR
+}  // namespace ATC
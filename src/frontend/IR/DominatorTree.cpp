@@ -0,0 +1,201 @@
+#include "IR/DominatorTree.h"
+
+#include <assert.h>
+
+#include "IR/Function.h"
+
+namespace ATC {
+namespace IR {
+
+DominatorTree::DominatorTree(Function* function, bool isPostDom) : _function(function), _isPostDom(isPostDom) {
+    buildGraph();
+    computeReversePostOrder();
+    computeIdom();
+    computeChildren();
+    computeFrontiers();
+}
+
+void DominatorTree::buildGraph() {
+    _blocks = _function->getBasicBlocks();
+    int num = _blocks.size();
+    for (int i = 0; i < num; i++) {
+        _blocks[i]->setIndex(i);
+    }
+    _rootIndex = num;
+    _succs.resize(num + 1);
+    _preds.resize(num + 1);
+
+    auto addEdge = [&](int from, int to) {
+        _succs[from].push_back(to);
+        _preds[to].push_back(from);
+    };
+    for (auto bb : _blocks) {
+        for (auto succ : bb->getSuccessors()) {
+            if (_isPostDom) {
+                addEdge(succ->getIndex(), bb->getIndex());
+            } else {
+                addEdge(bb->getIndex(), succ->getIndex());
+            }
+        }
+    }
+
+    if (_isPostDom) {
+        for (auto bb : _blocks) {
+            if (bb->getSuccessors().empty()) {
+                _roots.push_back(bb);
+            }
+        }
+    } else if (!_blocks.empty()) {
+        _roots.push_back(_blocks.front());
+    }
+    for (auto root : _roots) {
+        addEdge(_rootIndex, root->getIndex());
+    }
+}
+
+void DominatorTree::computeReversePostOrder() {
+    // iterative dfs, the generated functions may be too deep for recursion
+    std::vector<bool> visited(_rootIndex + 1, false);
+    std::vector<int> postOrder;
+    std::vector<std::pair<int, int>> stack;  // index and the position of next succ to visit
+    stack.push_back({_rootIndex, 0});
+    visited[_rootIndex] = true;
+    while (!stack.empty()) {
+        auto& [index, pos] = stack.back();
+        if (pos < (int)_succs[index].size()) {
+            int succ = _succs[index][pos++];
+            if (!visited[succ]) {
+                visited[succ] = true;
+                stack.push_back({succ, 0});
+            }
+            continue;
+        }
+        postOrder.push_back(index);
+        stack.pop_back();
+    }
+
+    _order.assign(postOrder.rbegin(), postOrder.rend());
+    _rpoNumber.assign(_rootIndex + 1, -1);
+    for (size_t i = 0; i < _order.size(); i++) {
+        _rpoNumber[_order[i]] = i;
+        if (_order[i] != _rootIndex) {
+            _rpo.push_back(_blocks[_order[i]]);
+        }
+    }
+}
+
+// "A Simple, Fast Dominance Algorithm" by Cooper, Harvey and Kennedy
+void DominatorTree::computeIdom() {
+    _idom.assign(_rootIndex + 1, -1);
+    _idom[_rootIndex] = _rootIndex;
+
+    auto intersect = [&](int finger1, int finger2) {
+        while (finger1 != finger2) {
+            while (_rpoNumber[finger1] > _rpoNumber[finger2]) {
+                finger1 = _idom[finger1];
+            }
+            while (_rpoNumber[finger2] > _rpoNumber[finger1]) {
+                finger2 = _idom[finger2];
+            }
+        }
+        return finger1;
+    };
+
+    bool changed;
+    do {
+        changed = false;
+        for (size_t i = 1; i < _order.size(); i++) {
+            int index = _order[i];
+            int newIdom = -1;
+            for (auto pred : _preds[index]) {
+                if (_idom[pred] == -1) {
+                    continue;
+                }
+                newIdom = newIdom == -1 ? pred : intersect(pred, newIdom);
+            }
+            if (_idom[index] != newIdom) {
+                _idom[index] = newIdom;
+                changed = true;
+            }
+        }
+    } while (changed);
+}
+
+void DominatorTree::computeChildren() {
+    _children.resize(_rootIndex);
+    std::vector<int> rootChildren;
+    for (size_t i = 1; i < _order.size(); i++) {
+        int index = _order[i];
+        if (_idom[index] == _rootIndex) {
+            rootChildren.push_back(index);
+        } else {
+            _children[_idom[index]].push_back(_blocks[index]);
+        }
+    }
+
+    // number the dominator tree, a dominates b iff b is in the subtree of a
+    _dfsIn.assign(_rootIndex + 1, -1);
+    _dfsOut.assign(_rootIndex + 1, -1);
+    int dfsNum = 0;
+    std::vector<std::pair<int, int>> stack;
+    stack.push_back({_rootIndex, 0});
+    _dfsIn[_rootIndex] = dfsNum++;
+    while (!stack.empty()) {
+        auto& [index, pos] = stack.back();
+        int childNum = index == _rootIndex ? rootChildren.size() : _children[index].size();
+        if (pos < childNum) {
+            int child = index == _rootIndex ? rootChildren[pos] : _children[index][pos]->getIndex();
+            pos++;
+            _dfsIn[child] = dfsNum++;
+            stack.push_back({child, 0});
+            continue;
+        }
+        _dfsOut[index] = dfsNum++;
+        stack.pop_back();
+    }
+}
+
+void DominatorTree::computeFrontiers() {
+    _frontiers.resize(_rootIndex);
+    for (size_t i = 1; i < _order.size(); i++) {
+        int index = _order[i];
+        if (_preds[index].size() < 2) {
+            continue;
+        }
+        for (auto pred : _preds[index]) {
+            if (_idom[pred] == -1) {
+                continue;
+            }
+            int runner = pred;
+            while (runner != _idom[index]) {
+                auto& frontier = _frontiers[runner];
+                // blocks are visited in order, so a duplicated one must be the last
+                if (frontier.empty() || frontier.back() != _blocks[index]) {
+                    frontier.push_back(_blocks[index]);
+                }
+                runner = _idom[runner];
+            }
+        }
+    }
+}
+
+BasicBlock* DominatorTree::getIdom(BasicBlock* bb) {
+    int idom = _idom[bb->getIndex()];
+    if (idom == -1 || idom == _rootIndex) {
+        return nullptr;
+    }
+    return _blocks[idom];
+}
+
+bool DominatorTree::dominates(BasicBlock* a, BasicBlock* b) {
+    int indexA = a->getIndex();
+    int indexB = b->getIndex();
+    assert(_blocks[indexA] == a && _blocks[indexB] == b && "the dominator tree is out of date");
+    if (!isReachable(a) || !isReachable(b)) {
+        return a == b;
+    }
+    return _dfsIn[indexA] <= _dfsIn[indexB] && _dfsOut[indexB] <= _dfsOut[indexA];
+}
+
+}  // namespace IR
+}  // namespace ATC
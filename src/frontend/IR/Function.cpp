@@ -1,8 +1,11 @@
 #include <assert.h>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
+#include "IR/DominatorTree.h"
+#include "IR/LoopInfo.h"
 #include "IR/Module.h"
 
 namespace ATC {
@@ -19,6 +22,79 @@ Function::Function(Module* parent, const FunctionType& functionType, const std::
     parent->addFunction(this);
 }
 
+void Function::insertBB(BasicBlock* bb) {
+    _basicBlocks.push_back(bb);
+    invalidateCFGAnalysis();
+}
+
+void Function::removeBB(BasicBlock* bb) {
+    _basicBlocks.erase(std::remove(_basicBlocks.begin(), _basicBlocks.end(), bb), _basicBlocks.end());
+    invalidateCFGAnalysis();
+}
+
+bool Function::removeUnreachableBB() {
+    auto domTree = getDominatorTree();
+    std::vector<BasicBlock*> unreachableBBs;
+    for (auto bb : _basicBlocks) {
+        if (!domTree->isReachable(bb)) {
+            unreachableBBs.push_back(bb);
+        }
+    }
+    // the dominator tree is invalidated once the cfg is changed
+    std::set<BasicBlock*> removed(unreachableBBs.begin(), unreachableBBs.end());
+    for (auto bb : unreachableBBs) {
+        for (auto succ : bb->getSuccessors()) {
+            if (removed.find(succ) != removed.end()) {
+                continue;
+            }
+            succ->removePredecessor(bb);
+            for (auto inst : succ->getInstructionList()) {
+                if (inst->getClassId() != ID_PHI_INST) {
+                    break;
+                }
+                static_cast<PhiInst*>(inst)->removeIncoming(bb);
+            }
+        }
+        for (auto inst : bb->getInstructionList()) {
+            inst->dropAllReferences();
+        }
+        removeBB(bb);
+    }
+    return !unreachableBBs.empty();
+}
+
+DominatorTree* Function::getDominatorTree() {
+    if (!_domTree) {
+        _domTree = new DominatorTree(this);
+    }
+    return _domTree;
+}
+
+DominatorTree* Function::getPostDominatorTree() {
+    if (!_postDomTree) {
+        _postDomTree = new DominatorTree(this, true);
+    }
+    return _postDomTree;
+}
+
+LoopInfo* Function::getLoopInfo() {
+    if (!_loopInfo) {
+        _loopInfo = new LoopInfo(this);
+    }
+    return _loopInfo;
+}
+
+void Function::invalidateCFGAnalysis() {
+    delete _loopInfo;
+    _loopInfo = nullptr;
+    delete _domTree;
+    _domTree = nullptr;
+    delete _postDomTree;
+    _postDomTree = nullptr;
+}
+
+std::vector<BasicBlock*> Function::getReversePostOrder() { return getDominatorTree()->getReversePostOrder(); }
+
 std::string Function::getUniqueNameInFunction(void* ptr) { return _nameMap[ptr]; }
 
 void Function::insertName(Value* value) { insertName(value, value->getName()); }
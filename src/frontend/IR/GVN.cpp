@@ -0,0 +1,130 @@
+#include "IR/GVN.h"
+
+#include <tuple>
+
+#include "IR/DominatorTree.h"
+
+namespace ATC {
+namespace IR {
+
+bool GVN::Expression::operator<(const Expression& other) const {
+    return std::tie(_classId, _instType, _type, _operands, _generation) <
+           std::tie(other._classId, other._instType, other._type, other._operands, other._generation);
+}
+
+bool GVN::runOnFunction(Function* function) {
+    _expr2value.clear();
+    _generation = 0;
+    _maxGeneration = 0;
+    _changed = false;
+
+    auto domTree = function->getDominatorTree();
+    std::vector<ScopeFrame> stack;
+    stack.push_back({domTree->getRoots().front(), 0, _generation, {}});
+    processBB(stack.back());
+    while (!stack.empty()) {
+        auto& frame = stack.back();
+        auto& children = domTree->getChildren(frame._bb);
+        if (frame._nextChild == children.size()) {
+            for (auto& expr : frame._insertedExprs) {
+                _expr2value.erase(expr);
+            }
+            stack.pop_back();
+            continue;
+        }
+        auto child = children[frame._nextChild++];
+        // the memory may be changed on other paths if the child has more than one predecessor
+        _generation = child->getPredecessors().size() == 1 ? frame._generation : ++_maxGeneration;
+        stack.push_back({child, 0, _generation, {}});
+        processBB(stack.back());
+    }
+    return _changed;
+}
+
+bool GVN::getExpression(Instruction* inst, Expression& expr) {
+    expr._classId = inst->getClassId();
+    expr._instType = 0;
+    expr._type = inst->getResult() ? inst->getResult()->getType() : nullptr;
+    expr._operands.clear();
+    expr._generation = 0;
+    switch (inst->getClassId()) {
+        case ID_GET_ELEMENT_PTR_INST:
+        case ID_BITCAST_INST:
+            break;
+        case ID_UNARY_INST:
+            expr._instType = static_cast<UnaryInst*>(inst)->getInstType();
+            if (expr._instType == UnaryInst::INST_LOAD) {
+                expr._generation = _generation;
+            }
+            break;
+        case ID_BINARY_INST: {
+            expr._instType = static_cast<BinaryInst*>(inst)->getInstType();
+            auto operand1 = inst->getOperand(0);
+            auto operand2 = inst->getOperand(1);
+            switch (expr._instType) {
+                case BinaryInst::INST_GT:
+                    expr._instType = BinaryInst::INST_LT;
+                    std::swap(operand1, operand2);
+                    break;
+                case BinaryInst::INST_GE:
+                    expr._instType = BinaryInst::INST_LE;
+                    std::swap(operand1, operand2);
+                    break;
+                case BinaryInst::INST_ADD:
+                case BinaryInst::INST_MUL:
+                case BinaryInst::INST_BIT_AND:
+                case BinaryInst::INST_BIT_OR:
+                case BinaryInst::INST_EQ:
+                case BinaryInst::INST_NE:
+                    if (operand2 < operand1) {
+                        std::swap(operand1, operand2);
+                    }
+                    break;
+                default:
+                    break;
+            }
+            expr._operands = {operand1, operand2};
+            return true;
+        }
+        default:
+            return false;
+    }
+    expr._operands = inst->getOperands();
+    return true;
+}
+
+void GVN::processBB(ScopeFrame& frame) {
+    Expression expr;
+    auto& instList = frame._bb->getInstructionList();
+    for (auto iter = instList.begin(); iter != instList.end();) {
+        auto inst = *iter;
+        if (inst->getClassId() == ID_STORE_INST) {
+            // the stored value can be forwarded to the following loads of the same address
+            auto storeInst = static_cast<StoreInst*>(inst);
+            _generation = ++_maxGeneration;
+            expr = {ID_UNARY_INST, UnaryInst::INST_LOAD, storeInst->getValue()->getType(), {storeInst->getDest()},
+                    _generation};
+            if (_expr2value.insert({expr, storeInst->getValue()}).second) {
+                frame._insertedExprs.push_back(expr);
+            }
+        } else if (inst->getClassId() == ID_FUNCTION_CALL_INST) {
+            _generation = ++_maxGeneration;
+        } else if (getExpression(inst, expr)) {
+            auto found = _expr2value.find(expr);
+            if (found != _expr2value.end()) {
+                inst->getResult()->replaceAllUsesWith(found->second);
+                inst->dropAllReferences();
+                iter = instList.erase(iter);
+                _changed = true;
+                continue;
+            }
+            _expr2value.insert({expr, inst->getResult()});
+            frame._insertedExprs.push_back(expr);
+        }
+        iter++;
+    }
+    frame._generation = _generation;
+}
+
+}  // namespace IR
+}  // namespace ATC
@@ -1,6 +1,7 @@
 #include "IR/IRBuilder.h"
 
 #include "../CmdOption.h"
+#include "../DataFlow.h"
 #include "AST/CompUnit.h"
 #include "AST/Expression.h"
 #include "AST/Function.h"
@@ -118,7 +119,10 @@ void IRBuilder::visit(FunctionDef *node) {
             createRet(nullptr);
         }
     }
-    maskDeadInst();
+    // the dead code will be erased by adce when optimizing
+    if (OptLevel == 0) {
+        maskDeadInst();
+    }
 }
 
 void IRBuilder::visit(Variable *node) {
@@ -853,143 +857,152 @@ Value *IRBuilder::getIndexedRefAddress(IndexedRef *indexedRef) {
 }
 
 void IRBuilder::maskDeadInst() {
-    bool update;
-    do {
-        update = false;
-        std::set<Value *> allocVar;
-        for (auto bb : _currentFunction->getBasicBlocks()) {
-            std::set<Value *> alives;
-            for (auto succ : bb->getSuccessors()) {
-                alives.insert(succ->getAlives().begin(), succ->getAlives().end());
+    // the params and the results of the insts are numbered densely, the constants and globals are never tracked
+    std::unordered_map<Value *, int> value2index;
+    for (auto param : _currentFunction->getParams()) {
+        value2index.insert({param, value2index.size()});
+    }
+    for (auto bb : _currentFunction->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            if (inst->getResult()) {
+                value2index.insert({inst->getResult(), value2index.size()});
             }
-            for (auto rbegin = bb->getInstructionList().rbegin(); rbegin != bb->getInstructionList().rend(); rbegin++) {
-                auto inst = *rbegin;
-                inst->setIsDead(false);
-                switch (inst->getClassId()) {
-                    case ID_ALLOC_INST: {
-                        auto allocInst = (AllocInst *)inst;
-                        if (alives.count(inst->getResult()) == 0) {
-                            inst->setIsDead(true);
-                        }
-                        break;
-                    }
-                    case ID_STORE_INST: {
-                        auto storeInst = (StoreInst *)inst;
-                        // store to global var and addr of GEP always alive(it hard to optmize)
-                        if (storeInst->getDest()->isGlobal()) {
-                            // needn't insert global addr to alives
-                            alives.insert(storeInst->getValue());
-                        } else if (storeInst->getDest()->getDefined()->getClassId() == ID_GET_ELEMENT_PTR_INST) {
-                            alives.insert(storeInst->getValue());
-                            alives.insert(storeInst->getDest());
-                        } else if (alives.count(storeInst->getDest()) == 0) {
-                            inst->setIsDead(true);
-                        } else {
-                            alives.insert(storeInst->getValue());
-                            // elimination to reduce the scale of propagation
-                            alives.erase(storeInst->getDest());
-                            allocVar.insert(storeInst->getDest());
-                        }
-                        break;
-                    }
-                    case ID_FUNCTION_CALL_INST: {
-                        // function call always alive(it hard to optmize)
-                        auto funCallInst = (FunctionCallInst *)inst;
-                        for (auto param : funCallInst->getParams()) {
-                            alives.insert(param);
-                        }
-                        break;
-                    }
-                    case ID_GET_ELEMENT_PTR_INST: {
-                        auto gepInst = (GetElementPtrInst *)inst;
-                        if (alives.count(gepInst->getResult()) == 0) {
-                            inst->setIsDead(true);
-                        } else {
-                            alives.insert(gepInst->getPtr());
-                            for (auto idx : gepInst->getIndexes()) {
-                                alives.insert(idx);
-                            }
-                        }
-                        break;
+        }
+    }
+    auto insert = [&](BitVector &alives, Value *value) {
+        auto iter = value2index.find(value);
+        if (iter != value2index.end()) {
+            alives.set(iter->second);
+        }
+    };
+    auto count = [&](BitVector &alives, Value *value) {
+        auto iter = value2index.find(value);
+        return iter != value2index.end() && alives.test(iter->second);
+    };
+
+    // the operands of an inst are alive only if the inst is alive, so it's not in gen/kill form
+    std::set<Value *> allocVar;
+    auto maskBlock = [&](BasicBlock *bb, BitVector &alives) {
+        for (auto rbegin = bb->getInstructionList().rbegin(); rbegin != bb->getInstructionList().rend(); rbegin++) {
+            auto inst = *rbegin;
+            inst->setIsDead(false);
+            switch (inst->getClassId()) {
+                case ID_ALLOC_INST: {
+                    if (!count(alives, inst->getResult())) {
+                        inst->setIsDead(true);
                     }
-                    case ID_BITCAST_INST: {
-                        auto bitCastInst = (BitCastInst *)inst;
-                        if (alives.count(bitCastInst->getResult()) == 0) {
-                            inst->setIsDead(true);
-                        } else {
-                            if (!bitCastInst->getPtr()->isGlobal()) {
-                                alives.insert(bitCastInst->getPtr());
-                            }
-                        }
-                        break;
+                    break;
+                }
+                case ID_STORE_INST: {
+                    auto storeInst = (StoreInst *)inst;
+                    // store to global var and addr of GEP always alive(it hard to optmize)
+                    if (storeInst->getDest()->isGlobal()) {
+                        // needn't insert global addr to alives
+                        insert(alives, storeInst->getValue());
+                    } else if (storeInst->getDest()->getDefined()->getClassId() == ID_GET_ELEMENT_PTR_INST) {
+                        insert(alives, storeInst->getValue());
+                        insert(alives, storeInst->getDest());
+                    } else if (!count(alives, storeInst->getDest())) {
+                        inst->setIsDead(true);
+                    } else {
+                        insert(alives, storeInst->getValue());
+                        // elimination to reduce the scale of propagation
+                        alives.reset(value2index[storeInst->getDest()]);
+                        allocVar.insert(storeInst->getDest());
                     }
-                    case ID_RETURN_INST: {
-                        alives.insert(static_cast<ReturnInst *>(inst)->getRetValue());
-                        break;
+                    break;
+                }
+                case ID_FUNCTION_CALL_INST: {
+                    // function call always alive(it hard to optmize)
+                    auto funCallInst = (FunctionCallInst *)inst;
+                    for (auto param : funCallInst->getParams()) {
+                        insert(alives, param);
                     }
-                    case ID_UNARY_INST: {
-                        auto unaryInst = (UnaryInst *)inst;
-                        if (alives.count(unaryInst->getResult()) == 0) {
-                            inst->setIsDead(true);
-                        } else {
-                            if (!unaryInst->getOperand()->isGlobal()) {
-                                alives.insert(unaryInst->getOperand());
-                            }
+                    break;
+                }
+                case ID_GET_ELEMENT_PTR_INST: {
+                    auto gepInst = (GetElementPtrInst *)inst;
+                    if (!count(alives, gepInst->getResult())) {
+                        inst->setIsDead(true);
+                    } else {
+                        insert(alives, gepInst->getPtr());
+                        for (auto idx : gepInst->getIndexes()) {
+                            insert(alives, idx);
                         }
-                        break;
                     }
-                    case ID_BINARY_INST: {
-                        auto binaryInst = (BinaryInst *)inst;
-                        if (alives.count(binaryInst->getResult()) == 0) {
-                            inst->setIsDead(true);
-                        } else {
-                            alives.insert(binaryInst->getOperand1());
-                            alives.insert(binaryInst->getOperand2());
-                        }
-                        break;
+                    break;
+                }
+                case ID_BITCAST_INST: {
+                    auto bitCastInst = (BitCastInst *)inst;
+                    if (!count(alives, bitCastInst->getResult())) {
+                        inst->setIsDead(true);
+                    } else {
+                        insert(alives, bitCastInst->getPtr());
                     }
-                    case ID_JUMP_INST: {
-                        break;
+                    break;
+                }
+                case ID_RETURN_INST: {
+                    insert(alives, static_cast<ReturnInst *>(inst)->getRetValue());
+                    break;
+                }
+                case ID_UNARY_INST: {
+                    auto unaryInst = (UnaryInst *)inst;
+                    if (!count(alives, unaryInst->getResult())) {
+                        inst->setIsDead(true);
+                    } else {
+                        insert(alives, unaryInst->getOperand());
                     }
-                    case ID_COND_JUMP_INST: {
-                        auto condJumpInst = (CondJumpInst *)inst;
-                        alives.insert(condJumpInst->getOperand1());
-                        alives.insert(condJumpInst->getOperand2());
-                        break;
+                    break;
+                }
+                case ID_BINARY_INST: {
+                    auto binaryInst = (BinaryInst *)inst;
+                    if (!count(alives, binaryInst->getResult())) {
+                        inst->setIsDead(true);
+                    } else {
+                        insert(alives, binaryInst->getOperand1());
+                        insert(alives, binaryInst->getOperand2());
                     }
-                    default:
-                        assert(0 && "can't not reach here");
-                        break;
+                    break;
+                }
+                case ID_JUMP_INST: {
+                    break;
                 }
-                if (inst->getResult()) {
-                    alives.erase(inst->getResult());
+                case ID_COND_JUMP_INST: {
+                    auto condJumpInst = (CondJumpInst *)inst;
+                    insert(alives, condJumpInst->getOperand1());
+                    insert(alives, condJumpInst->getOperand2());
+                    break;
                 }
+                default:
+                    assert(0 && "can't not reach here");
+                    break;
             }
-            if (bb->getAlives() != alives) {
-                update = true;
-                bb->setAlives(alives);
+            if (inst->getResult()) {
+                alives.reset(value2index[inst->getResult()]);
             }
         }
-        auto rbegin = _currentFunction->getBasicBlocks()[0]->getInstructionList().rbegin();
-        auto end = _currentFunction->getBasicBlocks()[0]->getInstructionList().rend();
-        // restore elimination by store
-        for (; rbegin != end; rbegin++) {
-            auto inst = *rbegin;
-            if (inst->isDead()) {
-                switch (inst->getClassId()) {
-                    case ID_ALLOC_INST: {
-                        auto allocInst = (AllocInst *)inst;
-                        if (allocVar.count(inst->getResult()) > 0) {
-                            inst->setIsDead(false);
-                        }
-                        break;
-                    }
-                    default:
-                        break;
-                }
-            }
+    };
+
+    auto blocks = _currentFunction->getReversePostOrder();
+    BackwardDataFlow<BasicBlock> dataFlow(blocks, value2index.size());
+    dataFlow.setTransfer([&](int index, BitVector &alives) { maskBlock(blocks[index], alives); });
+    dataFlow.solve();
+    // mask again with the final alives, the allocVar is collected in this round only
+    allocVar.clear();
+    for (size_t i = 0; i < blocks.size(); i++) {
+        BitVector alives = dataFlow.getOut(i);
+        maskBlock(blocks[i], alives);
+    }
+
+    auto rbegin = _currentFunction->getBasicBlocks()[0]->getInstructionList().rbegin();
+    auto end = _currentFunction->getBasicBlocks()[0]->getInstructionList().rend();
+    // restore elimination by store
+    for (; rbegin != end; rbegin++) {
+        auto inst = *rbegin;
+        if (inst->isDead() && inst->getClassId() == ID_ALLOC_INST && allocVar.count(inst->getResult()) > 0) {
+            inst->setIsDead(false);
         }
-    } while (update);
+    }
 }
 
 void IRBuilder::dumpIR(const std::string &filePath) { _currentModule->print(filePath); }
@@ -0,0 +1,169 @@
+#include "IR/InductionVariables.h"
+
+#include <stdint.h>
+
+namespace ATC {
+namespace IR {
+
+// the steps and coefficients are computed in int64, false if the result leaves int32
+static bool toInt32(long long value, int& result) {
+    if (value < INT32_MIN || value > INT32_MAX) {
+        return false;
+    }
+    result = value;
+    return true;
+}
+
+InductionVariables::InductionVariables(Loop* loop) : _loop(loop) {
+    for (auto bb : loop->getBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            _loopInsts.insert(inst);
+        }
+    }
+
+    auto preheader = loop->getPreheader();
+    if (!preheader || loop->getLatches().size() != 1) {
+        return;
+    }
+    auto latch = loop->getLatches().front();
+    for (auto inst : loop->getHeader()->getInstructionList()) {
+        if (inst->getClassId() != ID_PHI_INST) {
+            break;
+        }
+        auto phi = (PhiInst*)inst;
+        if (phi->getResult()->getType() != Type::getInt32Ty()) {
+            continue;
+        }
+        auto next = phi->getIncomingValue(latch)->getDefined();
+        if (!next || next->getClassId() != ID_BINARY_INST) {
+            continue;
+        }
+        auto increment = (BinaryInst*)next;
+        auto operand1 = increment->getOperand1();
+        auto operand2 = increment->getOperand2();
+        long long step;
+        if (increment->getInstType() == BinaryInst::INST_ADD && operand1 == phi->getResult() && operand2->isConst()) {
+            step = static_cast<ConstantInt*>(operand2)->getConstValue();
+        } else if (increment->getInstType() == BinaryInst::INST_ADD && operand2 == phi->getResult() &&
+                   operand1->isConst()) {
+            step = static_cast<ConstantInt*>(operand1)->getConstValue();
+        } else if (increment->getInstType() == BinaryInst::INST_SUB && operand1 == phi->getResult() &&
+                   operand2->isConst()) {
+            step = -(long long)static_cast<ConstantInt*>(operand2)->getConstValue();
+        } else {
+            continue;
+        }
+        // i - INT32_MIN
+        if (step > INT32_MAX) {
+            continue;
+        }
+        _basicIVs.push_back({phi, phi->getIncomingValue(preheader), (int)step, increment});
+    }
+}
+
+BasicInductionVariable* InductionVariables::getBasicIV(Value* value) {
+    for (auto& iv : _basicIVs) {
+        if (iv._phi->getResult() == value) {
+            return &iv;
+        }
+    }
+    return nullptr;
+}
+
+bool InductionVariables::isInvariant(Value* value) {
+    return !value->getDefined() || _loopInsts.find(value->getDefined()) == _loopInsts.end();
+}
+
+bool InductionVariables::getAffine(Value* value, AffineExpression& expr) {
+    if (!computeAffine(value, expr)) {
+        return false;
+    }
+    return expr._iv && expr._scale != 0;
+}
+
+bool InductionVariables::computeAffine(Value* value, AffineExpression& expr) {
+    expr = AffineExpression();
+    if (value->getType() != Type::getInt32Ty()) {
+        return false;
+    }
+    if (value->isConst()) {
+        expr._constant = static_cast<ConstantInt*>(value)->getConstValue();
+        return true;
+    }
+    if (isInvariant(value)) {
+        expr._terms.push_back({value, 1});
+        return true;
+    }
+    if (auto iv = getBasicIV(value)) {
+        expr._iv = iv;
+        expr._scale = 1;
+        return true;
+    }
+    if (_notAffine.find(value) != _notAffine.end()) {
+        return false;
+    }
+    auto iter = _affineCache.find(value);
+    if (iter != _affineCache.end()) {
+        expr = iter->second;
+        return true;
+    }
+
+    auto inst = value->getDefined();
+    if (inst->getClassId() != ID_BINARY_INST) {
+        _notAffine.insert(value);
+        return false;
+    }
+    auto binaryInst = (BinaryInst*)inst;
+    AffineExpression lhs, rhs;
+    if (!computeAffine(binaryInst->getOperand1(), lhs) || !computeAffine(binaryInst->getOperand2(), rhs)) {
+        _notAffine.insert(value);
+        return false;
+    }
+    bool inRange = true;
+    switch (binaryInst->getInstType()) {
+        case BinaryInst::INST_ADD:
+        case BinaryInst::INST_SUB: {
+            if (lhs._iv && rhs._iv && lhs._iv != rhs._iv) {
+                _notAffine.insert(value);
+                return false;
+            }
+            long long sign = binaryInst->getInstType() == BinaryInst::INST_SUB ? -1 : 1;
+            expr._iv = lhs._iv ? lhs._iv : rhs._iv;
+            inRange &= toInt32(lhs._scale + sign * rhs._scale, expr._scale);
+            expr._terms = lhs._terms;
+            for (auto [term, coefficient] : rhs._terms) {
+                expr._terms.push_back({term, 0});
+                inRange &= toInt32(sign * coefficient, expr._terms.back().second);
+            }
+            inRange &= toInt32(lhs._constant + sign * rhs._constant, expr._constant);
+            break;
+        }
+        case BinaryInst::INST_MUL: {
+            // one of the operands should be constant
+            if (!binaryInst->getOperand1()->isConst() && !binaryInst->getOperand2()->isConst()) {
+                _notAffine.insert(value);
+                return false;
+            }
+            long long factor = binaryInst->getOperand1()->isConst() ? lhs._constant : rhs._constant;
+            expr = binaryInst->getOperand1()->isConst() ? rhs : lhs;
+            inRange &= toInt32(expr._scale * factor, expr._scale);
+            for (auto& term : expr._terms) {
+                inRange &= toInt32(term.second * factor, term.second);
+            }
+            inRange &= toInt32(expr._constant * factor, expr._constant);
+            break;
+        }
+        default:
+            _notAffine.insert(value);
+            return false;
+    }
+    if (!inRange) {
+        _notAffine.insert(value);
+        return false;
+    }
+    _affineCache[value] = expr;
+    return true;
+}
+
+}  // namespace IR
+}  // namespace ATC
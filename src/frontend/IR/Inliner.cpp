@@ -0,0 +1,208 @@
+#include "IR/Inliner.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include "IR/Cloning.h"
+#include "IR/LoopInfo.h"
+
+namespace ATC {
+namespace IR {
+
+bool Inliner::runOnModule(Module* module) {
+    // the blocks which can't be reached may have no terminator or refer to the removed blocks
+    for (auto function : module->getFunctions()) {
+        function->removeUnreachableBB();
+    }
+
+    bool changed = false;
+    CallGraph callGraph(module);
+    _callGraph = &callGraph;
+    for (auto caller : callGraph.getBottomUpOrder()) {
+        bool inlined = false;
+        while (inlineOneCall(caller)) {
+            inlined = true;
+        }
+        if (inlined) {
+            caller->setHasFunctionCall(hasCall(caller));
+            changed = true;
+        }
+    }
+    // the functions of a unit linked with others may be called from them
+    if (!changed || !module->isWholeProgram() || !callGraph.getFunction("main")) {
+        return changed;
+    }
+
+    CallGraph newCallGraph(module);
+    for (auto function : std::vector<Function*>(module->getFunctions())) {
+        if (function->getName() != "main" && newCallGraph.getCallers(function).empty()) {
+            module->removeFunction(function);
+        }
+    }
+    return true;
+}
+
+bool Inliner::inlineOneCall(Function* caller) {
+    for (auto bb : caller->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            if (inst->getClassId() != ID_FUNCTION_CALL_INST) {
+                continue;
+            }
+            auto callInst = (FunctionCallInst*)inst;
+            auto callee = _callGraph->getFunction(callInst->getFuncName());
+            if (callee && shouldInline(callInst, bb, caller, callee)) {
+                inlineCall(callInst, bb, caller, callee);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Inliner::shouldInline(FunctionCallInst* callInst, BasicBlock* bb, Function* caller, Function* callee) {
+    if (callee == caller || _callGraph->isRecursive(callee) || !hasReturn(callee)) {
+        return false;
+    }
+    int calleeSize = getSize(callee);
+    if (getSize(caller) + calleeSize > MaxCallerSize) {
+        return false;
+    }
+    if (calleeSize <= AlwaysInlineSize && !hasCall(callee)) {
+        return true;
+    }
+
+    int cost = calleeSize - CallBenefit - callInst->getOperandNum();
+    for (auto arg : callInst->getParams()) {
+        if (arg->isConst()) {
+            cost -= ConstantArgBenefit;
+        }
+    }
+    int threshold = InlineThreshold;
+    if (_callGraph->getCallers(callee).size() == 1 && _callGraph->getCallSites(caller).size() == 1) {
+        threshold = OnlyCallThreshold;
+    }
+    // the calls in loop are executed many times
+    if (caller->getLoopInfo()->getLoopDepth(bb) > 0) {
+        threshold *= 2;
+    }
+    return cost <= threshold;
+}
+
+void Inliner::inlineCall(FunctionCallInst* callInst, BasicBlock* bb, Function* caller, Function* callee) {
+    // split the block after the call
+    auto afterCallBB = new BasicBlock(caller, "afterCallBB");
+    afterCallBB->setHasBr();
+    auto& instList = bb->getInstructionList();
+    auto callIter = std::find(instList.begin(), instList.end(), callInst);
+    auto& afterCallInstList = afterCallBB->getInstructionList();
+    afterCallInstList.splice(afterCallInstList.end(), instList, std::next(callIter), instList.end());
+    std::vector<BasicBlock*> succs = bb->getSuccessors();
+    for (auto succ : succs) {
+        bb->removeSuccessor(succ);
+        afterCallBB->addSuccessor(succ);
+        succ->replacePredecessor(bb, afterCallBB);
+        for (auto inst : succ->getInstructionList()) {
+            if (inst->getClassId() != ID_PHI_INST) {
+                break;
+            }
+            static_cast<PhiInst*>(inst)->replaceIncomingBB(bb, afterCallBB);
+        }
+    }
+
+    // substitute the arguments for the params
+    Cloner cloner(caller);
+    auto params = callee->getParams();
+    auto args = callInst->getParams();
+    for (size_t i = 0; i < params.size(); i++) {
+        cloner.mapValue(params[i], args[i]);
+    }
+    auto clonedBBs = cloner.cloneBBs(callee->getBasicBlocks());
+
+    // the local memory of callee is allocated once in the entry of caller
+    auto& entryInstList = caller->getBasicBlocks().front()->getInstructionList();
+    for (auto clonedBB : clonedBBs) {
+        auto& clonedInstList = clonedBB->getInstructionList();
+        for (auto iter = clonedInstList.begin(); iter != clonedInstList.end();) {
+            if ((*iter)->getClassId() == ID_ALLOC_INST) {
+                entryInstList.insert(std::prev(entryInstList.end()), *iter);
+                iter = clonedInstList.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
+    // the returns jump to the block after call
+    std::vector<std::pair<Value*, BasicBlock*>> returns;
+    for (auto clonedBB : clonedBBs) {
+        auto& clonedInstList = clonedBB->getInstructionList();
+        if (clonedInstList.back()->getClassId() != ID_RETURN_INST) {
+            continue;
+        }
+        returns.push_back({static_cast<ReturnInst*>(clonedInstList.back())->getRetValue(), clonedBB});
+        clonedInstList.back()->dropAllReferences();
+        clonedInstList.pop_back();
+        clonedInstList.push_back(new JumpInst(afterCallBB));
+    }
+    assert(!returns.empty() && "the callee should return");
+    auto result = callInst->getResult();
+    if (result && result->hasUses()) {
+        if (returns.size() == 1) {
+            result->replaceAllUsesWith(returns.front().first);
+        } else {
+            auto phi = new PhiInst(result->getType(), result->getName());
+            phi->getResult()->setBelongAndInsertName(caller);
+            for (auto& [value, returnBB] : returns) {
+                phi->addIncoming(value, returnBB);
+            }
+            afterCallInstList.push_front(phi);
+            result->replaceAllUsesWith(phi->getResult());
+        }
+    }
+
+    callInst->dropAllReferences();
+    instList.erase(callIter);
+    bb->addInstruction(new JumpInst(clonedBBs.front()));
+    addSuccessorEdges(bb);
+    for (auto clonedBB : clonedBBs) {
+        addSuccessorEdges(clonedBB);
+    }
+
+    std::vector<BasicBlock*> bbs = {bb};
+    bbs.insert(bbs.end(), clonedBBs.begin(), clonedBBs.end());
+    bbs.push_back(afterCallBB);
+    mergeBlocks(bbs);
+}
+
+int Inliner::getSize(Function* function) {
+    int size = 0;
+    for (auto bb : function->getBasicBlocks()) {
+        size += bb->getInstructionList().size();
+    }
+    return size;
+}
+
+bool Inliner::hasCall(Function* function) {
+    for (auto bb : function->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            if (inst->getClassId() == ID_FUNCTION_CALL_INST) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Inliner::hasReturn(Function* function) {
+    for (auto bb : function->getBasicBlocks()) {
+        if (bb->getInstructionList().back()->getClassId() == ID_RETURN_INST) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace IR
+}  // namespace ATC
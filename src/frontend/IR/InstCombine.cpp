@@ -0,0 +1,507 @@
+#include "IR/InstCombine.h"
+
+#include <assert.h>
+
+#include <climits>
+#include <tuple>
+
+#include "IR/SCCP.h"
+
+namespace ATC {
+namespace IR {
+
+const std::vector<InstCombine::BinaryRule> InstCombine::BinaryRules = {
+    &InstCombine::foldBinary,          &InstCombine::moveConstantRight,   &InstCombine::simplifyIdentity,
+    &InstCombine::simplifyNegation,    &InstCombine::reassociateConstant, &InstCombine::combineLikeTerms,
+    &InstCombine::simplifyBoolCompare,
+};
+
+const std::vector<InstCombine::UnaryRule> InstCombine::UnaryRules = {
+    &InstCombine::foldUnary,
+};
+
+const std::vector<InstCombine::CondJumpRule> InstCombine::CondJumpRules = {
+    &InstCombine::moveConstantRight,
+    &InstCombine::branchOnCompare,
+};
+
+bool InstCombine::runOnFunction(Function* function) {
+    _function = function;
+    _inst2bb.clear();
+    _worklist.clear();
+    _inWorklist.clear();
+
+    // the worklist is a stack, push in reverse so the definitions are visited before their uses
+    auto bbs = function->getReversePostOrder();
+    for (auto bbIter = bbs.rbegin(); bbIter != bbs.rend(); bbIter++) {
+        auto& instList = (*bbIter)->getInstructionList();
+        for (auto instIter = instList.rbegin(); instIter != instList.rend(); instIter++) {
+            _inst2bb[*instIter] = *bbIter;
+            push(*instIter);
+        }
+    }
+
+    bool changed = false;
+    while (!_worklist.empty()) {
+        auto inst = _worklist.back();
+        _worklist.pop_back();
+        _inWorklist.erase(inst);
+        // erased as dead
+        if (_inst2bb.find(inst) == _inst2bb.end()) {
+            continue;
+        }
+        changed |= visit(inst);
+    }
+    return changed;
+}
+
+bool InstCombine::visit(Instruction* inst) {
+    Value* replacement = nullptr;
+    switch (inst->getClassId()) {
+        case ID_BINARY_INST:
+            for (auto rule : BinaryRules) {
+                if ((replacement = (this->*rule)((BinaryInst*)inst))) {
+                    break;
+                }
+            }
+            break;
+        case ID_UNARY_INST:
+            for (auto rule : UnaryRules) {
+                if ((replacement = (this->*rule)((UnaryInst*)inst))) {
+                    break;
+                }
+            }
+            break;
+        case ID_COND_JUMP_INST: {
+            auto operands = inst->getOperands();
+            for (auto rule : CondJumpRules) {
+                if ((this->*rule)((CondJumpInst*)inst)) {
+                    push(inst);
+                    // the compare may be only used by the cond jump
+                    for (auto operand : operands) {
+                        if (auto defined = operand->getDefined()) {
+                            eraseIfDead(defined);
+                        }
+                    }
+                    return true;
+                }
+            }
+            return false;
+        }
+        default:
+            return false;
+    }
+    if (!replacement) {
+        return false;
+    }
+
+    pushUsers(inst->getResult());
+    inst->getResult()->replaceAllUsesWith(replacement);
+    eraseIfDead(inst);
+    return true;
+}
+
+Value* InstCombine::foldBinary(BinaryInst* inst) {
+    if (!inst->getOperand1()->isConst() || !inst->getOperand2()->isConst()) {
+        return nullptr;
+    }
+    return SCCP::foldBinary(inst->getInstType(), (Constant*)inst->getOperand1(), (Constant*)inst->getOperand2());
+}
+
+Value* InstCombine::moveConstantRight(BinaryInst* inst) {
+    // c op x -> x op c, c < x -> x > c
+    if (!inst->getOperand1()->isConst() || inst->getOperand2()->isConst()) {
+        return nullptr;
+    }
+    int type = inst->getInstType();
+    switch (type) {
+        case BinaryInst::INST_ADD:
+        case BinaryInst::INST_MUL:
+        case BinaryInst::INST_BIT_AND:
+        case BinaryInst::INST_BIT_OR:
+            break;
+        default:
+            if (!isCompare(type)) {
+                return nullptr;
+            }
+            type = getSwappedCompare(type);
+            break;
+    }
+    return insertBefore(inst, new BinaryInst(type, inst->getOperand2(), inst->getOperand1()));
+}
+
+Value* InstCombine::simplifyIdentity(BinaryInst* inst) {
+    // the float rules may change the sign of zero
+    if (!inst->isIntInst()) {
+        return nullptr;
+    }
+    auto operand1 = inst->getOperand1();
+    auto operand2 = inst->getOperand2();
+    if (operand1 == operand2) {
+        switch (inst->getInstType()) {
+            case BinaryInst::INST_SUB:
+                return ConstantInt::get(0);
+            case BinaryInst::INST_BIT_AND:
+            case BinaryInst::INST_BIT_OR:
+                return operand1;
+            case BinaryInst::INST_LE:
+            case BinaryInst::INST_GE:
+            case BinaryInst::INST_EQ:
+                return ConstantInt::get(1);
+            case BinaryInst::INST_LT:
+            case BinaryInst::INST_GT:
+            case BinaryInst::INST_NE:
+                return ConstantInt::get(0);
+            default:
+                return nullptr;
+        }
+    }
+    if (!operand2->isConst()) {
+        return nullptr;
+    }
+
+    int constant = static_cast<ConstantInt*>(operand2)->getConstValue();
+    switch (inst->getInstType()) {
+        case BinaryInst::INST_ADD:
+        case BinaryInst::INST_SUB:
+        case BinaryInst::INST_BIT_OR:
+            return constant == 0 ? operand1 : nullptr;
+        case BinaryInst::INST_MUL:
+            if (constant == -1) {
+                return insertBefore(inst, new BinaryInst(BinaryInst::INST_SUB, ConstantInt::get(0), operand1));
+            }
+            if (constant == 0) {
+                return ConstantInt::get(0);
+            }
+            return constant == 1 ? operand1 : nullptr;
+        case BinaryInst::INST_BIT_AND:
+            return constant == 0 ? ConstantInt::get(0) : nullptr;
+        case BinaryInst::INST_DIV:
+            if (constant == -1) {
+                return insertBefore(inst, new BinaryInst(BinaryInst::INST_SUB, ConstantInt::get(0), operand1));
+            }
+            return constant == 1 ? operand1 : nullptr;
+        case BinaryInst::INST_MOD:
+            return constant == 1 || constant == -1 ? ConstantInt::get(0) : nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+Value* InstCombine::simplifyNegation(BinaryInst* inst) {
+    if (!inst->isIntInst()) {
+        return nullptr;
+    }
+    auto operand1 = inst->getOperand1();
+    auto operand2 = inst->getOperand2();
+    auto negated1 = getNegatedOperand(operand1);
+    auto negated2 = getNegatedOperand(operand2);
+    switch (inst->getInstType()) {
+        case BinaryInst::INST_SUB:
+            // 0 - (0 - x) -> x
+            if (negated2 && operand1->isConst() && static_cast<ConstantInt*>(operand1)->getConstValue() == 0) {
+                return negated2;
+            }
+            // x - (0 - y) -> x + y
+            if (negated2) {
+                return insertBefore(inst, new BinaryInst(BinaryInst::INST_ADD, operand1, negated2));
+            }
+            return nullptr;
+        case BinaryInst::INST_ADD:
+            // x + (0 - y) -> x - y, (0 - x) + y -> y - x
+            if (negated2) {
+                return insertBefore(inst, new BinaryInst(BinaryInst::INST_SUB, operand1, negated2));
+            }
+            if (negated1) {
+                return insertBefore(inst, new BinaryInst(BinaryInst::INST_SUB, operand2, negated1));
+            }
+            return nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+Value* InstCombine::reassociateConstant(BinaryInst* inst) {
+    if (!inst->isIntInst()) {
+        return nullptr;
+    }
+    int type = inst->getInstType();
+    auto operand1 = inst->getOperand1();
+    auto operand2 = inst->getOperand2();
+    auto inner1 = operand1->getDefined() && operand1->getDefined()->getClassId() == ID_BINARY_INST
+                      ? (BinaryInst*)operand1->getDefined()
+                      : nullptr;
+    auto inner2 = operand2->getDefined() && operand2->getDefined()->getClassId() == ID_BINARY_INST
+                      ? (BinaryInst*)operand2->getDefined()
+                      : nullptr;
+
+    if (operand2->isConst()) {
+        unsigned constant = static_cast<ConstantInt*>(operand2)->getConstValue();
+        // x - c -> x + (-c)
+        if (type == BinaryInst::INST_SUB) {
+            return insertBefore(inst, new BinaryInst(BinaryInst::INST_ADD, operand1, ConstantInt::get(-constant)));
+        }
+        // (x + c1) + c2 -> x + (c1 + c2), (x * c1) * c2 -> x * (c1 * c2)
+        if ((type == BinaryInst::INST_ADD || type == BinaryInst::INST_MUL) && inner1 &&
+            inner1->getInstType() == type && inner1->getOperand2()->isConst()) {
+            unsigned innerConstant = static_cast<ConstantInt*>(inner1->getOperand2())->getConstValue();
+            unsigned combined = type == BinaryInst::INST_ADD ? innerConstant + constant : innerConstant * constant;
+            return insertBefore(inst, new BinaryInst(type, inner1->getOperand1(), ConstantInt::get(combined)));
+        }
+        return nullptr;
+    }
+
+    // move the constant out so it can be combined with the others, the inner one should be only used here:
+    // (x + c) + y -> (x + y) + c, (x + c) - y -> (x - y) + c
+    if ((type == BinaryInst::INST_ADD || type == BinaryInst::INST_SUB) && inner1 &&
+        inner1->getInstType() == BinaryInst::INST_ADD && inner1->getOperand2()->isConst() &&
+        operand1->getUsers().size() == 1) {
+        auto sum = insertBefore(inst, new BinaryInst(type, inner1->getOperand1(), operand2));
+        return insertBefore(inst, new BinaryInst(BinaryInst::INST_ADD, sum, inner1->getOperand2()));
+    }
+    // y + (x + c) -> (y + x) + c, y - (x + c) -> (y - x) + (-c)
+    if ((type == BinaryInst::INST_ADD || type == BinaryInst::INST_SUB) && inner2 &&
+        inner2->getInstType() == BinaryInst::INST_ADD && inner2->getOperand2()->isConst() &&
+        operand2->getUsers().size() == 1) {
+        unsigned constant = static_cast<ConstantInt*>(inner2->getOperand2())->getConstValue();
+        auto sum = insertBefore(inst, new BinaryInst(type, operand1, inner2->getOperand1()));
+        constant = type == BinaryInst::INST_ADD ? constant : -constant;
+        return insertBefore(inst, new BinaryInst(BinaryInst::INST_ADD, sum, ConstantInt::get(constant)));
+    }
+    return nullptr;
+}
+
+Value* InstCombine::combineLikeTerms(BinaryInst* inst) {
+    // (x +- a * y) +- b * y -> x +- c * y, and a * y +- b * y -> c * y
+    int type = inst->getInstType();
+    if (!inst->isIntInst() || (type != BinaryInst::INST_ADD && type != BinaryInst::INST_SUB)) {
+        return nullptr;
+    }
+    auto operand1 = inst->getOperand1();
+    auto [term2, coefficient2] = getTerm(inst->getOperand2());
+    if (term2->isConst()) {
+        return nullptr;
+    }
+    if (type == BinaryInst::INST_SUB) {
+        coefficient2 = -coefficient2;
+    }
+
+    auto [term1, coefficient1] = getTerm(operand1);
+    Value* rest = nullptr;
+    if (term1 != term2 || coefficient1 == 1) {
+        // x + a * y
+        auto inner = operand1->getDefined();
+        if (!inner || inner->getClassId() != ID_BINARY_INST || operand1->getUsers().size() != 1) {
+            return nullptr;
+        }
+        auto innerType = ((BinaryInst*)inner)->getInstType();
+        if (innerType != BinaryInst::INST_ADD && innerType != BinaryInst::INST_SUB) {
+            return nullptr;
+        }
+        std::tie(term1, coefficient1) = getTerm(((BinaryInst*)inner)->getOperand2());
+        if (term1 != term2) {
+            return nullptr;
+        }
+        if (innerType == BinaryInst::INST_SUB) {
+            coefficient1 = -coefficient1;
+        }
+        rest = ((BinaryInst*)inner)->getOperand1();
+    }
+
+    unsigned coefficient = (unsigned)coefficient1 + (unsigned)coefficient2;
+    int resultType = BinaryInst::INST_ADD;
+    if ((int)coefficient < 0 && (int)coefficient != INT_MIN && rest) {
+        resultType = BinaryInst::INST_SUB;
+        coefficient = -coefficient;
+    }
+    Value* product = term2;
+    if (coefficient == 0) {
+        product = ConstantInt::get(0);
+    } else if (coefficient != 1) {
+        product = insertBefore(inst, new BinaryInst(BinaryInst::INST_MUL, term2, ConstantInt::get(coefficient)));
+    }
+    if (!rest) {
+        return product;
+    }
+    return insertBefore(inst, new BinaryInst(resultType, rest, product));
+}
+
+Value* InstCombine::simplifyBoolCompare(BinaryInst* inst) {
+    // (x < y) != 0 -> x < y, (x < y) == 0 -> x >= y
+    int type = inst->getInstType();
+    if ((type != BinaryInst::INST_EQ && type != BinaryInst::INST_NE) || !inst->getOperand2()->isConst() ||
+        !inst->isIntInst()) {
+        return nullptr;
+    }
+    int constant = static_cast<ConstantInt*>(inst->getOperand2())->getConstValue();
+    auto compare = inst->getOperand1()->getDefined();
+    if ((constant != 0 && constant != 1) || !compare || compare->getClassId() != ID_BINARY_INST ||
+        !isCompare(((BinaryInst*)compare)->getInstType())) {
+        return nullptr;
+    }
+    if ((type == BinaryInst::INST_NE) == (constant == 0)) {
+        return inst->getOperand1();
+    }
+    // the inverted float compare is wrong for nan
+    if (!((BinaryInst*)compare)->isIntInst()) {
+        return nullptr;
+    }
+    auto invertedType = getInvertedCompare(((BinaryInst*)compare)->getInstType());
+    return insertBefore(inst, new BinaryInst(invertedType, compare->getOperand(0), compare->getOperand(1)));
+}
+
+Value* InstCombine::foldUnary(UnaryInst* inst) {
+    if (!inst->getOperand()->isConst()) {
+        return nullptr;
+    }
+    return SCCP::foldUnary(inst->getInstType(), (Constant*)inst->getOperand());
+}
+
+bool InstCombine::moveConstantRight(CondJumpInst* inst) {
+    auto operand1 = inst->getOperand1();
+    auto operand2 = inst->getOperand2();
+    if (!operand1->isConst() || operand2->isConst()) {
+        return false;
+    }
+    inst->setOperand(0, operand2);
+    inst->setOperand(1, operand1);
+    inst->setInstType(toCondJumpType(getSwappedCompare(toCompareType(inst->getInstType()))));
+    return true;
+}
+
+bool InstCombine::branchOnCompare(CondJumpInst* inst) {
+    // if (x < y) != 0 -> if x < y, if (x < y) == 0 -> if x >= y
+    int type = inst->getInstType();
+    if ((type != CondJumpInst::INST_JEQ && type != CondJumpInst::INST_JNE) || !inst->getOperand2()->isConst() ||
+        !inst->isIntInst()) {
+        return false;
+    }
+    int constant = static_cast<ConstantInt*>(inst->getOperand2())->getConstValue();
+    auto compare = inst->getOperand1()->getDefined();
+    if ((constant != 0 && constant != 1) || !compare || compare->getClassId() != ID_BINARY_INST ||
+        !isCompare(((BinaryInst*)compare)->getInstType())) {
+        return false;
+    }
+    int compareType = ((BinaryInst*)compare)->getInstType();
+    if ((type == CondJumpInst::INST_JNE) != (constant == 0)) {
+        if (!((BinaryInst*)compare)->isIntInst()) {
+            return false;
+        }
+        compareType = getInvertedCompare(compareType);
+    }
+    inst->setOperand(0, compare->getOperand(0));
+    inst->setOperand(1, compare->getOperand(1));
+    inst->setInstType(toCondJumpType(compareType));
+    return true;
+}
+
+Value* InstCombine::insertBefore(Instruction* pos, Instruction* inst) {
+    inst->getResult()->setBelongAndInsertName(_function);
+    auto bb = _inst2bb[pos];
+    auto& instList = bb->getInstructionList();
+    instList.insert(std::find(instList.begin(), instList.end(), pos), inst);
+    _inst2bb[inst] = bb;
+    push(inst);
+    return inst->getResult();
+}
+
+void InstCombine::push(Instruction* inst) {
+    if (_inWorklist.insert(inst).second) {
+        _worklist.push_back(inst);
+    }
+}
+
+void InstCombine::pushUsers(Value* value) {
+    for (auto user : value->getUsers()) {
+        push(user);
+    }
+}
+
+void InstCombine::eraseIfDead(Instruction* inst) {
+    // the loads are left to adce
+    if (inst->getClassId() != ID_BINARY_INST &&
+        (inst->getClassId() != ID_UNARY_INST || ((UnaryInst*)inst)->getInstType() == UnaryInst::INST_LOAD)) {
+        return;
+    }
+    if (_inst2bb.find(inst) == _inst2bb.end() || inst->getResult()->hasUses()) {
+        return;
+    }
+    auto operands = inst->getOperands();
+    inst->dropAllReferences();
+    auto& instList = _inst2bb[inst]->getInstructionList();
+    instList.erase(std::find(instList.begin(), instList.end(), inst));
+    _inst2bb.erase(inst);
+    for (auto operand : operands) {
+        if (auto defined = operand->getDefined()) {
+            eraseIfDead(defined);
+        }
+    }
+}
+
+Value* InstCombine::getNegatedOperand(Value* value) {
+    auto inst = value->getDefined();
+    if (!inst || inst->getClassId() != ID_BINARY_INST || ((BinaryInst*)inst)->getInstType() != BinaryInst::INST_SUB) {
+        return nullptr;
+    }
+    auto operand1 = ((BinaryInst*)inst)->getOperand1();
+    if (!operand1->isConst() || static_cast<ConstantInt*>(operand1)->getConstValue() != 0) {
+        return nullptr;
+    }
+    return ((BinaryInst*)inst)->getOperand2();
+}
+
+std::pair<Value*, int> InstCombine::getTerm(Value* value) {
+    auto inst = value->getDefined();
+    if (inst && inst->getClassId() == ID_BINARY_INST && ((BinaryInst*)inst)->getInstType() == BinaryInst::INST_MUL &&
+        ((BinaryInst*)inst)->getOperand2()->isConst()) {
+        return {((BinaryInst*)inst)->getOperand1(),
+                static_cast<ConstantInt*>(((BinaryInst*)inst)->getOperand2())->getConstValue()};
+    }
+    return {value, 1};
+}
+
+int InstCombine::getSwappedCompare(int type) {
+    switch (type) {
+        case BinaryInst::INST_LT:
+            return BinaryInst::INST_GT;
+        case BinaryInst::INST_LE:
+            return BinaryInst::INST_GE;
+        case BinaryInst::INST_GT:
+            return BinaryInst::INST_LT;
+        case BinaryInst::INST_GE:
+            return BinaryInst::INST_LE;
+        default:
+            return type;
+    }
+}
+
+int InstCombine::getInvertedCompare(int type) {
+    switch (type) {
+        case BinaryInst::INST_LT:
+            return BinaryInst::INST_GE;
+        case BinaryInst::INST_LE:
+            return BinaryInst::INST_GT;
+        case BinaryInst::INST_GT:
+            return BinaryInst::INST_LE;
+        case BinaryInst::INST_GE:
+            return BinaryInst::INST_LT;
+        case BinaryInst::INST_EQ:
+            return BinaryInst::INST_NE;
+        case BinaryInst::INST_NE:
+            return BinaryInst::INST_EQ;
+        default:
+            assert(false && "not a compare");
+            return type;
+    }
+}
+
+int InstCombine::toCondJumpType(int type) {
+    // the compares are in the same order
+    assert(isCompare(type) && "not a compare");
+    return type - BinaryInst::INST_LT + CondJumpInst::INST_JLT;
+}
+
+int InstCombine::toCompareType(int type) { return type - CondJumpInst::INST_JLT + BinaryInst::INST_LT; }
+
+}  // namespace IR
+}  // namespace ATC
@@ -10,6 +10,34 @@ bool AllocInst::AllocForParam = false;
 int AllocInst::AllocatedIntParamNum = 0;
 int AllocInst::AllocatedFloatParamNum = 0;
 
+std::vector<Value*> Instruction::getOperands() {
+    std::vector<Value*> operands;
+    for (auto use : _operands) {
+        operands.push_back(use->get());
+    }
+    return operands;
+}
+
+void Instruction::replaceOperand(Value* from, Value* to) {
+    for (auto use : _operands) {
+        if (use->get() == from) {
+            use->set(to);
+        }
+    }
+}
+
+void Instruction::dropAllReferences() {
+    for (auto use : _operands) {
+        use->removeFromList();
+    }
+    _operands.clear();
+}
+
+void Instruction::removeOperand(int index) {
+    _operands[index]->removeFromList();
+    _operands.erase(_operands.begin() + index);
+}
+
 AllocInst::AllocInst(Type* allocType, const std::string& resultName) : _allocForParam(AllocForParam) {
     if (AllocForParam) {
         if (allocType->isPointerType() || allocType == Type::getInt32Ty()) {
@@ -38,12 +66,18 @@ FunctionCallInst::FunctionCallInst(const FunctionType& functionType, const std::
         _result->setDefined(this);
     }
     _funcName = funcName;
-    _params = params;
+    for (auto param : params) {
+        addOperand(param);
+    }
 }
 
 GetElementPtrInst::GetElementPtrInst(Value* ptr, const std::vector<Value*>& indexes, const std::string& resultName)
-    : _ptr(ptr), _indexes(indexes) {
+{
     assert(ptr->getType()->isPointerType() && "should be pointer value");
+    addOperand(ptr);
+    for (auto index : indexes) {
+        addOperand(index);
+    }
     if (indexes.size() == 1) {
         _result = new Value(ptr->getType(), resultName);
     } else {
@@ -54,17 +88,19 @@ GetElementPtrInst::GetElementPtrInst(Value* ptr, const std::vector<Value*>& inde
     _result->setDefined(this);
 }
 
-BitCastInst::BitCastInst(Value* ptr, Type* destTy) : _ptr(ptr) {
+BitCastInst::BitCastInst(Value* ptr, Type* destTy) {
     assert(ptr->getType()->isPointerType() && destTy->isPointerType() && "only pointer can cast to pointer");
+    addOperand(ptr);
     _result = new Value(destTy, "");
     _result->setDefined(this);
 }
 
-UnaryInst::UnaryInst(int type, Value* operand, const std::string& resultName) : _type(type), _operand(operand) {
+UnaryInst::UnaryInst(int type, Value* operand, const std::string& resultName) : _type(type) {
+    addOperand(operand);
     switch (type) {
         case INST_LOAD:
-            assert(_operand->getType()->isPointerType() && "should load from a pointer");
-            _result = new Value(static_cast<PointerType*>(_operand->getType())->getBaseType(), resultName);
+            assert(operand->getType()->isPointerType() && "should load from a pointer");
+            _result = new Value(static_cast<PointerType*>(operand->getType())->getBaseType(), resultName);
             break;
         case INST_ITOF:
             _result = new Value(Type::getFloatTy(), resultName);
@@ -80,8 +116,10 @@ UnaryInst::UnaryInst(int type, Value* operand, const std::string& resultName) :
 }
 
 BinaryInst::BinaryInst(int type, Value* operand1, Value* operand2, const std::string& resultName)
-    : _type(type), _operand1(operand1), _operand2(operand2) {
-    assert(_operand1->getType() == _operand2->getType());
+    : _type(type) {
+    assert(operand1->getType() == operand2->getType());
+    addOperand(operand1);
+    addOperand(operand2);
     switch (type) {
         case INST_ADD:
         case INST_SUB:
@@ -90,7 +128,7 @@ BinaryInst::BinaryInst(int type, Value* operand1, Value* operand2, const std::st
         case INST_MOD:
         case INST_BIT_AND:
         case INST_BIT_OR:
-            _result = new Value(_operand1->getType(), resultName);
+            _result = new Value(operand1->getType(), resultName);
             break;
         case INST_LT:
         case INST_LE:
@@ -108,8 +146,71 @@ BinaryInst::BinaryInst(int type, Value* operand1, Value* operand2, const std::st
 }
 
 CondJumpInst::CondJumpInst(int type, BasicBlock* trueBB, BasicBlock* falseBB, Value* operand1, Value* operand2)
-    : _type(type), _trueBB(trueBB), _falseBB(falseBB), _operand1(operand1), _operand2(operand2) {
+    : _type(type), _trueBB(trueBB), _falseBB(falseBB) {
     assert(operand1->getType() == operand2->getType());
+    addOperand(operand1);
+    addOperand(operand2);
+}
+
+PhiInst::PhiInst(Type* type, const std::string& resultName) {
+    _result = new Value(type, resultName);
+    _result->setDefined(this);
+}
+
+std::vector<Value*> GetElementPtrInst::getIndexes() {
+    std::vector<Value*> indexes;
+    for (size_t i = 1; i < _operands.size(); i++) {
+        indexes.push_back(getOperand(i));
+    }
+    return indexes;
+}
+
+void PhiInst::addIncoming(Value* value, BasicBlock* bb) {
+    addOperand(value);
+    _incomingBBs.push_back(bb);
+}
+
+std::vector<std::pair<Value*, BasicBlock*>> PhiInst::getIncomings() {
+    std::vector<std::pair<Value*, BasicBlock*>> incomings;
+    for (size_t i = 0; i < _incomingBBs.size(); i++) {
+        incomings.push_back({getOperand(i), _incomingBBs[i]});
+    }
+    return incomings;
+}
+
+Value* PhiInst::getIncomingValue(BasicBlock* bb) {
+    for (size_t i = 0; i < _incomingBBs.size(); i++) {
+        if (_incomingBBs[i] == bb) {
+            return getOperand(i);
+        }
+    }
+    assert(false && "should not reach here");
+    return nullptr;
+}
+
+void PhiInst::setIncomingValue(BasicBlock* bb, Value* value) {
+    for (size_t i = 0; i < _incomingBBs.size(); i++) {
+        if (_incomingBBs[i] == bb) {
+            setOperand(i, value);
+        }
+    }
+}
+
+void PhiInst::replaceIncomingBB(BasicBlock* from, BasicBlock* to) {
+    for (auto& incomingBB : _incomingBBs) {
+        if (incomingBB == from) {
+            incomingBB = to;
+        }
+    }
+}
+
+void PhiInst::removeIncoming(BasicBlock* bb) {
+    for (int i = _incomingBBs.size() - 1; i >= 0; i--) {
+        if (_incomingBBs[i] == bb) {
+            removeOperand(i);
+            _incomingBBs.erase(_incomingBBs.begin() + i);
+        }
+    }
 }
 
 std::string AllocInst::toString() {
@@ -124,7 +225,7 @@ std::string AllocInst::toString() {
 
 std::string StoreInst::toString() {
     std::string str = "store";
-    str.append(" ").append(_value->toString()).append(", ").append(_dest->toString());
+    str.append(" ").append(getValue()->toString()).append(", ").append(getDest()->toString());
     return str;
 }
 
@@ -140,7 +241,7 @@ std::string FunctionCallInst::toString() {
             .append(_result->getType()->toString());
     }
     str.append(" @").append(_funcName).append("(");
-    for (auto param : _params) {
+    for (auto param : getParams()) {
         str.append(param->toString()).append(", ");
     }
     if (str.back() == ' ') {
@@ -153,8 +254,8 @@ std::string FunctionCallInst::toString() {
 
 std::string GetElementPtrInst::toString() {
     std::string str;
-    str.append(_result->getValueStr()).append(" = getelementptr ").append(_ptr->toString());
-    for (auto index : _indexes) {
+    str.append(_result->getValueStr()).append(" = getelementptr ").append(getPtr()->toString());
+    for (auto index : getIndexes()) {
         str.append(", ").append(index->toString());
     }
     return str;
@@ -164,7 +265,7 @@ std::string BitCastInst::toString() {
     std::string str;
     str.append(_result->getValueStr())
         .append(" = bitcast ")
-        .append(_ptr->toString())
+        .append(getPtr()->toString())
         .append(" to ")
         .append(_result->getType()->toString());
     return str;
@@ -172,8 +273,8 @@ std::string BitCastInst::toString() {
 
 std::string ReturnInst::toString() {
     std::string str = "ret";
-    if (_retValue) {
-        str.append(" ").append(_retValue->toString());
+    if (auto retValue = getRetValue()) {
+        str.append(" ").append(retValue->toString());
     }
     return str;
 }
@@ -184,25 +285,25 @@ std::string UnaryInst::toString() {
 
     switch (_type) {
         case INST_LOAD: {
-            PointerType* operandType = (PointerType*)_operand->getType();
+            PointerType* operandType = (PointerType*)getOperand()->getType();
             str.append("load")
                 .append(" ")
                 .append(operandType->getBaseType()->toString())
                 .append(", ")
-                .append(_operand->toString());
+                .append(getOperand()->toString());
             break;
         }
         case INST_ITOF:
             str.append("itof")
                 .append(" ")
-                .append(_operand->toString())
+                .append(getOperand()->toString())
                 .append(" to ")
                 .append(_result->getType()->toString());
             break;
         case INST_FTOI:
             str.append("ftoi")
                 .append(" ")
-                .append(_operand->toString())
+                .append(getOperand()->toString())
                 .append(" to ")
                 .append(_result->getType()->toString());
             break;
@@ -258,7 +359,7 @@ std::string BinaryInst::toString() {
             assert(false && " should not reach here");
             break;
     }
-    str.append(_operand1->toString()).append(", ").append(_operand2->getValueStr());
+    str.append(getOperand1()->toString()).append(", ").append(getOperand2()->getValueStr());
     return str;
 }
 
@@ -270,7 +371,7 @@ std::string JumpInst::toString() {
 
 std::string CondJumpInst::toString() {
     std::string str;
-    str.append("if").append(" ").append(_operand1->getValueStr());
+    str.append("if").append(" ").append(getOperand1()->getValueStr());
     switch (_type) {
         case INST_JLT:
             str.append(" < ");
@@ -295,7 +396,7 @@ std::string CondJumpInst::toString() {
             break;
     }
 
-    str.append(_operand2->getValueStr())
+    str.append(getOperand2()->getValueStr())
         .append(" ")
         .append("jump")
         .append(" ")
@@ -310,5 +411,65 @@ std::string CondJumpInst::toString() {
     return str;
 }
 
+std::string PhiInst::toString() {
+    std::string str;
+    str.append(_result->getValueStr()).append(" = phi ").append(_result->getType()->toString());
+    for (auto& [value, bb] : getIncomings()) {
+        str.append(" [").append(value->getValueStr()).append(", ").append(bb->getBBStr()).append("],");
+    }
+    if (str.back() == ',') {
+        str.pop_back();
+    }
+    return str;
+}
+
+Instruction* AllocInst::clone() { return new AllocInst(static_cast<PointerType*>(_result->getType())->getBaseType()); }
+
+Instruction* StoreInst::clone() { return new StoreInst(getValue(), getDest()); }
+
+Instruction* FunctionCallInst::clone() {
+    std::vector<Type*> paramTypes;
+    for (auto param : getParams()) {
+        paramTypes.push_back(param->getType());
+    }
+    auto functionType = FunctionType::get(_result ? _result->getType() : Type::getVoidTy(), paramTypes, false);
+    return new FunctionCallInst(*functionType, _funcName, getParams());
+}
+
+Instruction* GetElementPtrInst::clone() { return new GetElementPtrInst(getPtr(), getIndexes()); }
+
+Instruction* BitCastInst::clone() { return new BitCastInst(getPtr(), _result->getType()); }
+
+Instruction* ReturnInst::clone() { return new ReturnInst(getRetValue()); }
+
+Instruction* UnaryInst::clone() { return new UnaryInst(_type, getOperand()); }
+
+Instruction* BinaryInst::clone() { return new BinaryInst(_type, getOperand1(), getOperand2()); }
+
+Instruction* JumpInst::clone() { return new JumpInst(_targetBB); }
+
+Instruction* CondJumpInst::clone() { return new CondJumpInst(_type, _trueBB, _falseBB, getOperand1(), getOperand2()); }
+
+Instruction* PhiInst::clone() {
+    auto phi = new PhiInst(_result->getType());
+    for (auto& [value, bb] : getIncomings()) {
+        phi->addIncoming(value, bb);
+    }
+    return phi;
+}
+
+Value* getBaseAddr(Value* addr) {
+    while (auto defined = addr->getDefined()) {
+        if (defined->getClassId() == ID_GET_ELEMENT_PTR_INST) {
+            addr = static_cast<GetElementPtrInst*>(defined)->getPtr();
+        } else if (defined->getClassId() == ID_BITCAST_INST) {
+            addr = static_cast<BitCastInst*>(defined)->getPtr();
+        } else {
+            break;
+        }
+    }
+    return addr;
+}
+
 }  // namespace IR
 }  // namespace ATC
\ No newline at end of file
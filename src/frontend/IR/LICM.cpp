@@ -0,0 +1,228 @@
+#include "IR/LICM.h"
+
+#include <assert.h>
+
+#include <iterator>
+
+#include "IR/BreakCriticalEdges.h"
+#include "IR/DominatorTree.h"
+
+namespace ATC {
+namespace IR {
+
+bool LICM::runOnFunction(Function* function) {
+    _function = function;
+    bool changed = insertPreheaders();
+
+    _inst2bb.clear();
+    for (auto bb : function->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            _inst2bb[inst] = bb;
+        }
+    }
+    for (auto loop : function->getLoopInfo()->getLoopsInPostOrder()) {
+        changed |= hoist(loop);
+    }
+    return changed;
+}
+
+bool LICM::insertPreheaders() {
+    // collect first, the loop info is invalidated once the cfg is changed
+    std::vector<std::pair<BasicBlock*, std::vector<BasicBlock*>>> headers;
+    for (auto loop : _function->getLoopInfo()->getLoopsInPostOrder()) {
+        if (loop->getPreheader()) {
+            continue;
+        }
+        std::vector<BasicBlock*> outsidePreds;
+        for (auto pred : loop->getHeader()->getPredecessors()) {
+            if (!loop->contains(pred)) {
+                outsidePreds.push_back(pred);
+            }
+        }
+        headers.push_back({loop->getHeader(), outsidePreds});
+    }
+    for (auto& [header, outsidePreds] : headers) {
+        insertPreheader(header, outsidePreds);
+    }
+    return !headers.empty();
+}
+
+void LICM::insertPreheader(BasicBlock* header, const std::vector<BasicBlock*>& outsidePreds) {
+    assert(!outsidePreds.empty() && "the header should be reachable from entry");
+    if (outsidePreds.size() == 1) {
+        BreakCriticalEdges::splitEdge(outsidePreds.front(), header);
+        return;
+    }
+
+    auto preheader = new BasicBlock(_function, "preheaderBB");
+    for (auto pred : outsidePreds) {
+        auto terminator = pred->getInstructionList().back();
+        if (terminator->getClassId() == ID_JUMP_INST) {
+            static_cast<JumpInst*>(terminator)->setTargetBB(preheader);
+        } else {
+            assert(terminator->getClassId() == ID_COND_JUMP_INST && "should be the terminator");
+            auto condJumpInst = (CondJumpInst*)terminator;
+            if (condJumpInst->getTureBB() == header) {
+                condJumpInst->setTrueBB(preheader);
+            }
+            if (condJumpInst->getFalseBB() == header) {
+                condJumpInst->setFalseBB(preheader);
+            }
+        }
+        pred->replaceSuccessor(header, preheader);
+        preheader->addPredecessor(pred);
+        header->removePredecessor(pred);
+    }
+
+    // the incomings from outside are merged by a new phi in preheader
+    for (auto inst : header->getInstructionList()) {
+        if (inst->getClassId() != ID_PHI_INST) {
+            break;
+        }
+        auto phi = (PhiInst*)inst;
+        auto newPhi = new PhiInst(phi->getResult()->getType(), phi->getResult()->getName());
+        newPhi->getResult()->setBelongAndInsertName(_function);
+        for (auto pred : outsidePreds) {
+            newPhi->addIncoming(phi->getIncomingValue(pred), pred);
+            phi->removeIncoming(pred);
+        }
+        phi->addIncoming(newPhi->getResult(), preheader);
+        preheader->addInstruction(newPhi);
+    }
+
+    preheader->addInstruction(new JumpInst(header));
+    preheader->setHasBr();
+    preheader->addSuccessor(header);
+    header->addPredecessor(preheader);
+}
+
+bool LICM::hoist(Loop* loop) {
+    auto preheader = loop->getPreheader();
+    assert(preheader && "the preheader should be inserted");
+
+    _hasCall = false;
+    _storedBases.clear();
+    for (auto bb : loop->getBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            if (inst->getClassId() == ID_FUNCTION_CALL_INST) {
+                _hasCall = true;
+            } else if (inst->getClassId() == ID_STORE_INST) {
+                _storedBases.insert(getBaseAddr(static_cast<StoreInst*>(inst)->getDest()));
+            }
+        }
+    }
+
+    // the operands are visited before their users in reverse post order
+    bool changed = false;
+    auto& preheaderInsts = preheader->getInstructionList();
+    for (auto bb : loop->getBlocks()) {
+        auto& instList = bb->getInstructionList();
+        for (auto iter = instList.begin(); iter != instList.end();) {
+            auto inst = *iter;
+            if (!canHoist(inst, loop)) {
+                iter++;
+                continue;
+            }
+            iter = instList.erase(iter);
+            preheaderInsts.insert(std::prev(preheaderInsts.end()), inst);
+            _inst2bb[inst] = preheader;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool LICM::isInvariant(Value* value, Loop* loop) {
+    // constants, globals and params
+    if (!value->getDefined()) {
+        return true;
+    }
+    return !loop->contains(_inst2bb[value->getDefined()]);
+}
+
+bool LICM::canHoist(Instruction* inst, Loop* loop) {
+    switch (inst->getClassId()) {
+        case ID_BINARY_INST: {
+            auto binaryInst = (BinaryInst*)inst;
+            if (binaryInst->isIntInst() && (binaryInst->getInstType() == BinaryInst::INST_DIV ||
+                                            binaryInst->getInstType() == BinaryInst::INST_MOD)) {
+                // the inst may not be executed in loop, don't hoist the division which may be illegal
+                auto divisor = binaryInst->getOperand2();
+                if (!divisor->isConst()) {
+                    return false;
+                }
+                int value = static_cast<ConstantInt*>(divisor)->getConstValue();
+                if (value == 0 || value == -1) {
+                    return false;
+                }
+            }
+            break;
+        }
+        case ID_UNARY_INST:
+            if (static_cast<UnaryInst*>(inst)->getInstType() == UnaryInst::INST_LOAD &&
+                !isLoadInvariant((UnaryInst*)inst, loop)) {
+                return false;
+            }
+            break;
+        case ID_GET_ELEMENT_PTR_INST:
+        case ID_BITCAST_INST:
+            break;
+        default:
+            return false;
+    }
+    for (auto operand : inst->getOperands()) {
+        if (!isInvariant(operand, loop)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LICM::isLoadInvariant(UnaryInst* inst, Loop* loop) {
+    if (_hasCall) {
+        return false;
+    }
+    // only hoist the load executed in every iteration, and at least once whenever the loop is entered. it dominates
+    // every exiting block, so a load guarded by the loop condition is never run speculatively on a zero-trip entry
+    auto domTree = _function->getDominatorTree();
+    auto bb = _inst2bb[inst];
+    for (auto latch : loop->getLatches()) {
+        if (!domTree->dominates(bb, latch)) {
+            return false;
+        }
+    }
+    for (auto loopBB : loop->getBlocks()) {
+        for (auto succ : loopBB->getSuccessors()) {
+            if (!loop->contains(succ) && !domTree->dominates(bb, loopBB)) {
+                return false;
+            }
+        }
+    }
+
+    auto base = getBaseAddr(inst->getOperand());
+    for (auto storedBase : _storedBases) {
+        if (mayAlias(storedBase, base)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LICM::mayAlias(Value* base1, Value* base2) {
+    if (base1 == base2) {
+        return true;
+    }
+    auto isAlloca = [](Value* base) {
+        return base->getDefined() && base->getDefined()->getClassId() == ID_ALLOC_INST;
+    };
+    auto isParam = [](Value* base) { return !base->getDefined() && !base->isGlobal() && !base->isConst(); };
+    // the memory of different globals and allocas never overlaps, the pointer params point to the memory of caller.
+    // a phi or a loaded pointer may point to anything, e.g. a param phi of TRE which gets a local array after inlining
+    if ((isAlloca(base1) || base1->isGlobal()) && (isAlloca(base2) || base2->isGlobal())) {
+        return false;
+    }
+    return !(isAlloca(base1) && isParam(base2)) && !(isAlloca(base2) && isParam(base1));
+}
+
+}  // namespace IR
+}  // namespace ATC
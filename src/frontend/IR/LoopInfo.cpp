@@ -0,0 +1,146 @@
+#include "IR/LoopInfo.h"
+
+#include "IR/DominatorTree.h"
+#include "IR/Function.h"
+
+namespace ATC {
+namespace IR {
+
+bool Loop::contains(Loop* loop) {
+    while (loop && loop != this) {
+        loop = loop->getParentLoop();
+    }
+    return loop == this;
+}
+
+BasicBlock* Loop::getPreheader() {
+    BasicBlock* preheader = nullptr;
+    for (auto pred : _header->getPredecessors()) {
+        if (contains(pred)) {
+            continue;
+        }
+        if (preheader) {
+            return nullptr;
+        }
+        preheader = pred;
+    }
+    if (!preheader || preheader->getSuccessors().size() != 1) {
+        return nullptr;
+    }
+    return preheader;
+}
+
+std::vector<BasicBlock*> Loop::getExitBlocks() {
+    std::vector<BasicBlock*> exitBlocks;
+    std::set<BasicBlock*> visited;
+    for (auto bb : _blocks) {
+        for (auto succ : bb->getSuccessors()) {
+            if (!contains(succ) && visited.insert(succ).second) {
+                exitBlocks.push_back(succ);
+            }
+        }
+    }
+    return exitBlocks;
+}
+
+LoopInfo::LoopInfo(Function* function) : _function(function) {
+    auto domTree = function->getDominatorTree();
+    auto& rpo = domTree->getReversePostOrder();
+
+    // the inner headers are dominated by the outer ones, so they are discovered first in post order
+    for (auto iter = rpo.rbegin(); iter != rpo.rend(); iter++) {
+        auto header = *iter;
+        std::vector<BasicBlock*> latches;
+        for (auto pred : header->getPredecessors()) {
+            if (domTree->isReachable(pred) && domTree->dominates(header, pred)) {
+                latches.push_back(pred);
+            }
+        }
+        if (!latches.empty()) {
+            discoverLoop(header, latches);
+        }
+    }
+
+    // fill the blocks in reverse post order, every block belongs to its innermost loop and all the parents
+    for (auto bb : rpo) {
+        for (auto loop = getLoopFor(bb); loop; loop = loop->_parentLoop) {
+            loop->_blocks.push_back(bb);
+            loop->_blockSet.insert(bb);
+        }
+    }
+
+    for (auto bb : rpo) {
+        auto loop = getLoopFor(bb);
+        if (loop && loop->_header == bb && !loop->_parentLoop) {
+            _topLevelLoops.push_back(loop);
+        }
+    }
+    for (auto loop : _topLevelLoops) {
+        computePostOrder(loop);
+    }
+}
+
+LoopInfo::~LoopInfo() {
+    for (auto loop : _postOrderLoops) {
+        delete loop;
+    }
+}
+
+Loop* LoopInfo::getLoopFor(BasicBlock* bb) {
+    auto iter = _bb2loop.find(bb);
+    return iter == _bb2loop.end() ? nullptr : iter->second;
+}
+
+int LoopInfo::getLoopDepth(BasicBlock* bb) {
+    auto loop = getLoopFor(bb);
+    return loop ? loop->getDepth() : 0;
+}
+
+void LoopInfo::discoverLoop(BasicBlock* header, const std::vector<BasicBlock*>& latches) {
+    auto domTree = _function->getDominatorTree();
+    auto loop = new Loop(header);
+    loop->_latches = latches;
+    _bb2loop[header] = loop;
+
+    // walk backward from the latches to the header
+    std::vector<BasicBlock*> worklist(latches.begin(), latches.end());
+    while (!worklist.empty()) {
+        auto bb = worklist.back();
+        worklist.pop_back();
+        auto subLoop = getLoopFor(bb);
+        if (!subLoop) {
+            _bb2loop[bb] = loop;
+            for (auto pred : bb->getPredecessors()) {
+                if (domTree->isReachable(pred)) {
+                    worklist.push_back(pred);
+                }
+            }
+            continue;
+        }
+        while (subLoop->_parentLoop) {
+            subLoop = subLoop->_parentLoop;
+        }
+        if (subLoop == loop) {
+            continue;
+        }
+        // the outermost loop found so far becomes a sub loop, continue from the predecessors of its header
+        subLoop->_parentLoop = loop;
+        loop->_subLoops.push_back(subLoop);
+        for (auto pred : subLoop->_header->getPredecessors()) {
+            if (domTree->isReachable(pred) && getLoopFor(pred) != subLoop) {
+                worklist.push_back(pred);
+            }
+        }
+    }
+}
+
+void LoopInfo::computePostOrder(Loop* loop) {
+    for (auto subLoop : loop->_subLoops) {
+        subLoop->_depth = loop->_depth + 1;
+        computePostOrder(subLoop);
+    }
+    _postOrderLoops.push_back(loop);
+}
+
+}  // namespace IR
+}  // namespace ATC
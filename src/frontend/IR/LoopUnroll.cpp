@@ -0,0 +1,334 @@
+#include "IR/LoopUnroll.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+#include "CmdOption.h"
+#include "IR/Cloning.h"
+
+namespace ATC {
+namespace IR {
+
+bool LoopUnroll::runOnFunction(Function* function) {
+    if (UnrollFactor <= 1) {
+        return false;
+    }
+    _function = function;
+    _visitedHeaders.clear();
+
+    bool changed = false;
+    while (true) {
+        // the loop info is invalidated after unrolling, so find the candidates one by one
+        UnrollCandidate candidate;
+        bool found = false;
+        for (auto loop : function->getLoopInfo()->getLoopsInPostOrder()) {
+            if (_visitedHeaders.insert(loop->getHeader()).second && analyzeLoop(loop, candidate)) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            break;
+        }
+        unroll(candidate);
+        changed = true;
+    }
+    return changed;
+}
+
+bool LoopUnroll::analyzeLoop(Loop* loop, UnrollCandidate& candidate) {
+    if (!loop->getSubLoops().empty() || !loop->getPreheader() || loop->getLatches().size() != 1) {
+        return false;
+    }
+    auto header = loop->getHeader();
+    auto terminator = header->getInstructionList().back();
+    if (terminator->getClassId() != ID_COND_JUMP_INST) {
+        return false;
+    }
+    auto condJumpInst = (CondJumpInst*)terminator;
+    bool trueInLoop = loop->contains(condJumpInst->getTureBB());
+    if (trueInLoop == loop->contains(condJumpInst->getFalseBB())) {
+        return false;
+    }
+
+    // the header should be the only exiting block, so the iterations can run without testing
+    int size = 0;
+    for (auto bb : loop->getBlocks()) {
+        size += bb->getInstructionList().size();
+        if (bb == header) {
+            continue;
+        }
+        for (auto succ : bb->getSuccessors()) {
+            if (!loop->contains(succ)) {
+                return false;
+            }
+        }
+    }
+    if (size * UnrollFactor > UnrollBudget) {
+        return false;
+    }
+
+    InductionVariables ivs(loop);
+    int type = condJumpInst->getInstType();
+    auto iv = ivs.getBasicIV(condJumpInst->getOperand1());
+    auto limit = condJumpInst->getOperand2();
+    if (!iv) {
+        iv = ivs.getBasicIV(condJumpInst->getOperand2());
+        limit = condJumpInst->getOperand1();
+        type = getSwappedType(type);
+    }
+    if (!iv || !ivs.isInvariant(limit)) {
+        return false;
+    }
+    if (!trueInLoop) {
+        type = getNegatedType(type);
+    }
+    // the iv should move towards the limit, then the last one of the next iterations decides whether all of them run
+    bool increasing = iv->_step > 0 && (type == CondJumpInst::INST_JLT || type == CondJumpInst::INST_JLE);
+    bool decreasing = iv->_step < 0 && (type == CondJumpInst::INST_JGT || type == CondJumpInst::INST_JGE);
+    if (!increasing && !decreasing) {
+        return false;
+    }
+    // the unrolled header tests "iv type limit - step * (factor - 1)", the steps and a constant adjusted limit must
+    // be in int32
+    long long stride = (long long)iv->_step * UnrollFactor;
+    if (stride > INT32_MAX || stride < -INT32_MAX) {
+        return false;
+    }
+    if (limit->isConst()) {
+        long long adjusted = static_cast<ConstantInt*>(limit)->getConstValue() - (stride - iv->_step);
+        if (adjusted < INT32_MIN || adjusted > INT32_MAX) {
+            return false;
+        }
+    }
+
+    candidate._blocks = loop->getBlocks();
+    candidate._header = header;
+    candidate._latch = loop->getLatches().front();
+    candidate._preheader = loop->getPreheader();
+    candidate._bodyBB = trueInLoop ? condJumpInst->getTureBB() : condJumpInst->getFalseBB();
+    candidate._exitBB = trueInLoop ? condJumpInst->getFalseBB() : condJumpInst->getTureBB();
+    candidate._basicIVs = ivs.getBasicIVs();
+    candidate._iv = *iv;
+    candidate._limit = limit;
+    candidate._type = type;
+
+    long long tripCount = getTripCount(candidate);
+    return tripCount < 0 || tripCount >= UnrollFactor;
+}
+
+void LoopUnroll::unroll(UnrollCandidate& candidate) {
+    int factor = UnrollFactor;
+    auto header = candidate._header;
+    auto preheader = candidate._preheader;
+    auto unrolledHeader = new BasicBlock(_function, "unrolledHeaderBB");
+    unrolledHeader->setHasBr();
+    _visitedHeaders.insert(unrolledHeader);
+
+    // the values of header phis at the beginning of current iteration
+    std::vector<PhiInst*> phis;
+    std::vector<Value*> currents;
+    std::unordered_map<Value*, Value*> unrolledPhis;
+    for (auto inst : header->getInstructionList()) {
+        if (inst->getClassId() != ID_PHI_INST) {
+            break;
+        }
+        auto phi = (PhiInst*)inst;
+        auto unrolledPhi = new PhiInst(phi->getResult()->getType(), phi->getResult()->getName());
+        unrolledPhi->getResult()->setBelongAndInsertName(_function);
+        unrolledHeader->addInstruction(unrolledPhi);
+        phis.push_back(phi);
+        currents.push_back(unrolledPhi->getResult());
+        unrolledPhis[phi->getResult()] = unrolledPhi->getResult();
+    }
+
+    std::vector<BasicBlock*> clonedBBs;
+    std::vector<BasicBlock*> headers;
+    std::vector<BasicBlock*> latches;
+    for (int i = 0; i < factor; i++) {
+        Cloner cloner(_function);
+        for (size_t j = 0; j < phis.size(); j++) {
+            cloner.mapValue(phis[j]->getResult(), currents[j]);
+        }
+        auto bbs = cloner.cloneBBs(candidate._blocks);
+        clonedBBs.insert(clonedBBs.end(), bbs.begin(), bbs.end());
+
+        // the test is done in unrolled header
+        auto& instList = cloner.getBB(header)->getInstructionList();
+        instList.back()->dropAllReferences();
+        instList.pop_back();
+        instList.push_back(new JumpInst(cloner.getBB(candidate._bodyBB)));
+
+        // compute the induction variables from the unrolled header instead of the previous iteration, so they are
+        // still the basic ones of unrolled loop
+        for (auto& iv : candidate._basicIVs) {
+            auto increment = cloner.getValue(iv._increment->getResult())->getDefined();
+            int ivIndex = increment->getOperand(0) == cloner.getValue(iv._phi->getResult()) ? 0 : 1;
+            int step = static_cast<ConstantInt*>(increment->getOperand(1 - ivIndex))->getConstValue();
+            increment->setOperand(ivIndex, unrolledPhis[iv._phi->getResult()]);
+            increment->setOperand(1 - ivIndex, ConstantInt::get(step * (i + 1)));
+        }
+
+        std::vector<Value*> nexts;
+        for (auto phi : phis) {
+            nexts.push_back(cloner.getValue(phi->getIncomingValue(candidate._latch)));
+        }
+        currents = nexts;
+        headers.push_back(cloner.getBB(header));
+        latches.push_back(cloner.getBB(candidate._latch));
+    }
+    for (int i = 0; i < factor; i++) {
+        replaceTarget(latches[i]->getInstructionList().back(), headers[i],
+                      i + 1 < factor ? headers[i + 1] : unrolledHeader);
+    }
+
+    // run the unrolled iterations if the last one can run. the limit is adjusted instead of adding to the iv, which
+    // may wrap around near the bounds of int32
+    auto& iv = candidate._iv;
+    int delta = iv._step * (factor - 1);
+    auto entryBB = preheader;
+    Value* adjustedLimit;
+    if (candidate._limit->isConst()) {
+        adjustedLimit = ConstantInt::get(static_cast<ConstantInt*>(candidate._limit)->getConstValue() - delta);
+    } else {
+        // the adjusted limit overflows only if the unrolled loop can never run, so skip it in that case
+        entryBB = new BasicBlock(_function, "unrolledPreheaderBB");
+        entryBB->setHasBr();
+        auto sub = new BinaryInst(BinaryInst::INST_SUB, candidate._limit, ConstantInt::get(delta));
+        sub->getResult()->setBelongAndInsertName(_function);
+        entryBB->addInstruction(sub);
+        entryBB->addInstruction(new JumpInst(unrolledHeader));
+        adjustedLimit = sub->getResult();
+
+        auto& instList = preheader->getInstructionList();
+        instList.back()->dropAllReferences();
+        instList.pop_back();
+        if (delta > 0) {
+            instList.push_back(new CondJumpInst(CondJumpInst::INST_JGE, entryBB, header, candidate._limit,
+                                                ConstantInt::get(INT32_MIN + delta)));
+        } else {
+            instList.push_back(new CondJumpInst(CondJumpInst::INST_JLE, entryBB, header, candidate._limit,
+                                                ConstantInt::get(INT32_MAX + delta)));
+        }
+        preheader->removeSuccessor(header);
+        header->removePredecessor(preheader);
+        addSuccessorEdges(preheader);
+        addSuccessorEdges(entryBB);
+    }
+
+    for (size_t j = 0; j < phis.size(); j++) {
+        auto unrolledPhi = (PhiInst*)unrolledPhis[phis[j]->getResult()]->getDefined();
+        unrolledPhi->addIncoming(phis[j]->getIncomingValue(preheader), entryBB);
+        unrolledPhi->addIncoming(currents[j], latches.back());
+    }
+    unrolledHeader->addInstruction(new CondJumpInst(candidate._type, headers.front(), header,
+                                                    unrolledPhis[iv._phi->getResult()], adjustedLimit));
+
+    // the original loop runs the remaining iterations
+    if (entryBB == preheader) {
+        replaceTarget(preheader->getInstructionList().back(), header, unrolledHeader);
+        preheader->replaceSuccessor(header, unrolledHeader);
+        unrolledHeader->addPredecessor(preheader);
+        header->removePredecessor(preheader);
+        for (auto phi : phis) {
+            phi->replaceIncomingBB(preheader, unrolledHeader);
+            phi->setIncomingValue(unrolledHeader, unrolledPhis[phi->getResult()]);
+        }
+    } else {
+        for (auto phi : phis) {
+            phi->addIncoming(unrolledPhis[phi->getResult()], unrolledHeader);
+        }
+    }
+    addSuccessorEdges(unrolledHeader);
+    for (auto bb : clonedBBs) {
+        addSuccessorEdges(bb);
+    }
+    mergeBlocks(clonedBBs);
+}
+
+long long LoopUnroll::getTripCount(UnrollCandidate& candidate) {
+    auto& iv = candidate._iv;
+    if (!iv._init->isConst() || !candidate._limit->isConst()) {
+        return -1;
+    }
+    long long init = static_cast<ConstantInt*>(iv._init)->getConstValue();
+    long long limit = static_cast<ConstantInt*>(candidate._limit)->getConstValue();
+    long long step = iv._step;
+    long long distance;
+    switch (candidate._type) {
+        case CondJumpInst::INST_JLT:
+            distance = limit - init;
+            break;
+        case CondJumpInst::INST_JLE:
+            distance = limit - init + 1;
+            break;
+        case CondJumpInst::INST_JGT:
+            distance = init - limit;
+            step = -step;
+            break;
+        case CondJumpInst::INST_JGE:
+            distance = init - limit + 1;
+            step = -step;
+            break;
+        default:
+            assert(false && "should not reach here");
+            break;
+    }
+    return distance > 0 ? (distance + step - 1) / step : 0;
+}
+
+int LoopUnroll::getSwappedType(int type) {
+    switch (type) {
+        case CondJumpInst::INST_JLT:
+            return CondJumpInst::INST_JGT;
+        case CondJumpInst::INST_JLE:
+            return CondJumpInst::INST_JGE;
+        case CondJumpInst::INST_JGT:
+            return CondJumpInst::INST_JLT;
+        case CondJumpInst::INST_JGE:
+            return CondJumpInst::INST_JLE;
+        default:
+            return type;
+    }
+}
+
+int LoopUnroll::getNegatedType(int type) {
+    switch (type) {
+        case CondJumpInst::INST_JLT:
+            return CondJumpInst::INST_JGE;
+        case CondJumpInst::INST_JLE:
+            return CondJumpInst::INST_JGT;
+        case CondJumpInst::INST_JGT:
+            return CondJumpInst::INST_JLE;
+        case CondJumpInst::INST_JGE:
+            return CondJumpInst::INST_JLT;
+        case CondJumpInst::INST_JEQ:
+            return CondJumpInst::INST_JNE;
+        case CondJumpInst::INST_JNE:
+            return CondJumpInst::INST_JEQ;
+        default:
+            assert(false && "should not reach here");
+            return type;
+    }
+}
+
+void LoopUnroll::replaceTarget(Instruction* terminator, BasicBlock* from, BasicBlock* to) {
+    if (terminator->getClassId() == ID_JUMP_INST) {
+        auto jumpInst = (JumpInst*)terminator;
+        if (jumpInst->getTargetBB() == from) {
+            jumpInst->setTargetBB(to);
+        }
+        return;
+    }
+    assert(terminator->getClassId() == ID_COND_JUMP_INST && "should be the terminator");
+    auto condJumpInst = (CondJumpInst*)terminator;
+    if (condJumpInst->getTureBB() == from) {
+        condJumpInst->setTrueBB(to);
+    }
+    if (condJumpInst->getFalseBB() == from) {
+        condJumpInst->setFalseBB(to);
+    }
+}
+
+}  // namespace IR
+}  // namespace ATC
@@ -0,0 +1,246 @@
+#include "IR/Mem2Reg.h"
+
+#include <assert.h>
+
+#include <algorithm>
+
+namespace ATC {
+namespace IR {
+
+bool Mem2Reg::runOnFunction(Function* function) {
+    _function = function;
+    _allocas.clear();
+    _alloca2index.clear();
+    _phi2index.clear();
+    _valueStacks.clear();
+    _replaceMap.clear();
+
+    bool changed = _function->removeUnreachableBB();
+    _domTree = _function->getDominatorTree();
+    _rpo = _domTree->getReversePostOrder();
+    collectPromotableAllocas();
+    if (!_allocas.empty()) {
+        insertPhis();
+        rename();
+        removePromotedInsts();
+        changed = true;
+    }
+    return changed;
+}
+
+void Mem2Reg::collectPromotableAllocas() {
+    // all allocas are in the entry block
+    auto& entryInsts = _rpo.front()->getInstructionList();
+    std::set<Value*> candidates;
+    for (auto inst : entryInsts) {
+        if (inst->getClassId() == ID_ALLOC_INST && !inst->getResult()->getType()->getBaseType()->isArrayType()) {
+            candidates.insert(inst->getResult());
+        }
+    }
+
+    // the alloca can't be promoted if its address is used by other instructions
+    for (auto bb : _rpo) {
+        for (auto inst : bb->getInstructionList()) {
+            if (inst->getClassId() == ID_UNARY_INST &&
+                static_cast<UnaryInst*>(inst)->getInstType() == UnaryInst::INST_LOAD) {
+                continue;
+            }
+            if (inst->getClassId() == ID_STORE_INST) {
+                candidates.erase(static_cast<StoreInst*>(inst)->getValue());
+                continue;
+            }
+            for (auto operand : inst->getOperands()) {
+                candidates.erase(operand);
+            }
+        }
+    }
+
+    for (auto inst : entryInsts) {
+        if (inst->getClassId() == ID_ALLOC_INST && candidates.find(inst->getResult()) != candidates.end()) {
+            _alloca2index[inst->getResult()] = _allocas.size();
+            _allocas.push_back((AllocInst*)inst);
+        }
+    }
+    _valueStacks.resize(_allocas.size());
+}
+
+void Mem2Reg::insertPhis() {
+    std::vector<std::set<BasicBlock*>> defBBs(_allocas.size());
+    for (auto bb : _rpo) {
+        for (auto inst : bb->getInstructionList()) {
+            if (inst->getClassId() != ID_STORE_INST) {
+                continue;
+            }
+            auto iter = _alloca2index.find(static_cast<StoreInst*>(inst)->getDest());
+            if (iter != _alloca2index.end()) {
+                defBBs[iter->second].insert(bb);
+            }
+        }
+    }
+
+    // insert phi at the iterated dominance frontier of the blocks which store the alloca
+    for (size_t i = 0; i < _allocas.size(); i++) {
+        Value* allocaResult = _allocas[i]->getResult();
+        Type* type = allocaResult->getType()->getBaseType();
+        std::set<BasicBlock*> hasPhi;
+        std::vector<BasicBlock*> worklist(defBBs[i].begin(), defBBs[i].end());
+        while (!worklist.empty()) {
+            auto bb = worklist.back();
+            worklist.pop_back();
+            for (auto frontier : _domTree->getDominanceFrontier(bb)) {
+                if (!hasPhi.insert(frontier).second) {
+                    continue;
+                }
+                auto phi = new PhiInst(type, allocaResult->getName());
+                phi->getResult()->setBelongAndInsertName(_function);
+                frontier->getInstructionList().push_front(phi);
+                _phi2index[phi] = i;
+                if (defBBs[i].find(frontier) == defBBs[i].end()) {
+                    worklist.push_back(frontier);
+                }
+            }
+        }
+    }
+}
+
+void Mem2Reg::rename() {
+    // iterative walk of the dominator tree, the generated functions may be too deep for recursion
+    struct Frame {
+        BasicBlock* _bb;
+        size_t _childPos;
+        std::vector<int> _pushed;  // the value stacks to pop when leaving the block
+    };
+    std::vector<Frame> stack;
+    stack.push_back({_rpo.front(), 0, renameBlock(_rpo.front())});
+    while (!stack.empty()) {
+        auto& frame = stack.back();
+        auto& children = _domTree->getChildren(frame._bb);
+        if (frame._childPos < children.size()) {
+            auto child = children[frame._childPos++];
+            stack.push_back({child, 0, renameBlock(child)});
+            continue;
+        }
+        for (auto index : frame._pushed) {
+            _valueStacks[index].pop_back();
+        }
+        stack.pop_back();
+    }
+}
+
+std::vector<int> Mem2Reg::renameBlock(BasicBlock* bb) {
+    std::vector<int> pushed;
+    auto getCurrentValue = [&](int index, Type* type) {
+        auto& stack = _valueStacks[index];
+        return stack.empty() ? getUndefValue(type) : stack.back();
+    };
+
+    for (auto inst : bb->getInstructionList()) {
+        switch (inst->getClassId()) {
+            case ID_PHI_INST: {
+                auto iter = _phi2index.find((PhiInst*)inst);
+                if (iter != _phi2index.end()) {
+                    _valueStacks[iter->second].push_back(inst->getResult());
+                    pushed.push_back(iter->second);
+                }
+                break;
+            }
+            case ID_UNARY_INST: {
+                auto unaryInst = (UnaryInst*)inst;
+                if (unaryInst->getInstType() != UnaryInst::INST_LOAD) {
+                    break;
+                }
+                auto iter = _alloca2index.find(unaryInst->getOperand());
+                if (iter != _alloca2index.end()) {
+                    _replaceMap[inst->getResult()] = getCurrentValue(iter->second, inst->getResult()->getType());
+                }
+                break;
+            }
+            case ID_STORE_INST: {
+                auto storeInst = (StoreInst*)inst;
+                auto iter = _alloca2index.find(storeInst->getDest());
+                if (iter != _alloca2index.end()) {
+                    Value* value = storeInst->getValue();
+                    if (_replaceMap.find(value) != _replaceMap.end()) {
+                        value = _replaceMap[value];
+                    }
+                    _valueStacks[iter->second].push_back(value);
+                    pushed.push_back(iter->second);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    for (auto succ : bb->getSuccessors()) {
+        for (auto inst : succ->getInstructionList()) {
+            if (inst->getClassId() != ID_PHI_INST) {
+                break;
+            }
+            auto phi = (PhiInst*)inst;
+            auto iter = _phi2index.find(phi);
+            if (iter == _phi2index.end()) {
+                continue;
+            }
+            // the succ may be both the true and false target of a cond jump
+            bool exist = false;
+            for (auto& [value, incomingBB] : phi->getIncomings()) {
+                if (incomingBB == bb) {
+                    exist = true;
+                    break;
+                }
+            }
+            if (!exist) {
+                phi->addIncoming(getCurrentValue(iter->second, phi->getResult()->getType()), bb);
+            }
+        }
+    }
+
+    return pushed;
+}
+
+void Mem2Reg::removePromotedInsts() {
+    for (auto& [loadResult, value] : _replaceMap) {
+        loadResult->replaceAllUsesWith(value);
+    }
+
+    for (auto bb : _rpo) {
+        auto& instList = bb->getInstructionList();
+        for (auto iter = instList.begin(); iter != instList.end();) {
+            auto inst = *iter;
+            bool promoted = false;
+            switch (inst->getClassId()) {
+                case ID_ALLOC_INST:
+                    promoted = _alloca2index.find(inst->getResult()) != _alloca2index.end();
+                    break;
+                case ID_STORE_INST:
+                    promoted = _alloca2index.find(static_cast<StoreInst*>(inst)->getDest()) != _alloca2index.end();
+                    break;
+                case ID_UNARY_INST:
+                    promoted = _replaceMap.find(inst->getResult()) != _replaceMap.end();
+                    break;
+                default:
+                    break;
+            }
+            if (promoted) {
+                inst->dropAllReferences();
+                iter = instList.erase(iter);
+                continue;
+            }
+            iter++;
+        }
+    }
+}
+
+Value* Mem2Reg::getUndefValue(Type* type) {
+    // the value of uninitialized local variable is undefined, use zero here
+    if (type == Type::getFloatTy()) {
+        return ConstantFloat::get(0);
+    }
+    assert(type == Type::getInt32Ty() && "should be int or float");
+    return ConstantInt::get(0);
+}
+
+}  // namespace IR
+}  // namespace ATC
@@ -1,11 +1,16 @@
 #include "IR/Module.h"
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
 namespace ATC {
 namespace IR {
 
+void Module::removeFunction(Function* function) {
+    _functions.erase(std::remove(_functions.begin(), _functions.end(), function), _functions.end());
+}
+
 std::string Module::toString() {
     std::stringstream ss;
     for (auto item : _globalVariables) {
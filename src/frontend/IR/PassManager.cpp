@@ -0,0 +1,124 @@
+#include "IR/PassManager.h"
+
+#include <chrono>
+#include <iomanip>
+
+#include "IR/ADCE.h"
+#include "IR/BreakCriticalEdges.h"
+#include "IR/GVN.h"
+#include "IR/InstCombine.h"
+#include "IR/Inliner.h"
+#include "IR/LICM.h"
+#include "IR/LoopUnroll.h"
+#include "IR/Mem2Reg.h"
+#include "IR/SCCP.h"
+#include "IR/StrengthReduction.h"
+#include "IR/TailRecursionElimination.h"
+
+namespace ATC {
+namespace IR {
+
+PassManager::~PassManager() {
+    for (auto& entry : _passes) {
+        delete entry._modulePass;
+        delete entry._functionPass;
+    }
+}
+
+void PassManager::addPass(ModulePass* pass) { _passes.push_back({pass, nullptr}); }
+
+void PassManager::addPass(FunctionPass* pass) { _passes.push_back({nullptr, pass}); }
+
+void PassManager::buildPipeline(int optLevel) {
+    if (optLevel == 0) {
+        return;
+    }
+    // -O1 only runs the cheap scalar passes, -O2 adds the ones that cost compile time or grow the code
+    addPass(new Mem2Reg());
+    addPass(new TailRecursionElimination());
+    if (optLevel >= 2) {
+        addPass(new Inliner());
+    }
+    addPass(new SCCP());
+    addPass(new InstCombine());
+    if (optLevel >= 2) {
+        addPass(new GVN());
+        addPass(new LICM());
+        addPass(new LoopUnroll());
+        addPass(new StrengthReduction());
+    }
+    addPass(new ADCE());
+    // must be the last one, the backend needs it to lower phi
+    addPass(new BreakCriticalEdges());
+}
+
+bool PassManager::run(Module* module) {
+    bool changed = false;
+    for (auto& entry : _passes) {
+        if (entry._modulePass) {
+            changed |= runModulePass(entry._modulePass, module);
+        } else {
+            changed |= runFunctionPass(entry._functionPass, module);
+        }
+    }
+    return changed;
+}
+
+bool PassManager::runModulePass(ModulePass* pass, Module* module) {
+    auto start = std::chrono::steady_clock::now();
+    bool changed = pass->runOnModule(module);
+    if (changed && !pass->preservesCFG()) {
+        for (auto function : module->getFunctions()) {
+            function->invalidateCFGAnalysis();
+        }
+    }
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    addTime(pass->getName(), duration.count());
+    return changed;
+}
+
+bool PassManager::runFunctionPass(FunctionPass* pass, Module* module) {
+    auto start = std::chrono::steady_clock::now();
+    bool changed = false;
+    for (auto function : module->getFunctions()) {
+        if (pass->runOnFunction(function)) {
+            changed = true;
+            if (!pass->preservesCFG()) {
+                function->invalidateCFGAnalysis();
+            }
+        }
+    }
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    addTime(pass->getName(), duration.count());
+    return changed;
+}
+
+void PassManager::addTime(const std::string& name, double seconds) {
+    if (_name2seconds.find(name) == _name2seconds.end()) {
+        _timeOrder.push_back(name);
+    }
+    _name2seconds[name] += seconds;
+}
+
+void PassManager::printTimeReport(std::ostream& os) {
+    double total = 0;
+    for (auto& [name, seconds] : _name2seconds) {
+        total += seconds;
+    }
+    os << "===-------------------------------------------------------------------------===" << std::endl;
+    os << "                          ... Pass execution timing report ..." << std::endl;
+    os << "===-------------------------------------------------------------------------===" << std::endl;
+    os << "  Total Execution Time: " << std::fixed << std::setprecision(4) << total << " seconds" << std::endl;
+    os << std::endl;
+    os << "   --Wall Time--   --Name--" << std::endl;
+    for (auto& name : _timeOrder) {
+        double seconds = _name2seconds[name];
+        double percent = total > 0 ? seconds * 100 / total : 0;
+        os << "  " << std::setw(7) << seconds << " (" << std::setw(5) << std::setprecision(1) << percent << "%)  "
+           << name << std::endl;
+        os << std::setprecision(4);
+    }
+}
+
+}  // namespace IR
+}  // namespace ATC
@@ -0,0 +1,374 @@
+#include "IR/SCCP.h"
+
+#include <assert.h>
+
+#include <climits>
+
+namespace ATC {
+namespace IR {
+
+bool SCCP::runOnFunction(Function* function) {
+    _function = function;
+    _lattice.clear();
+    _inst2bb.clear();
+    _executableBBs.clear();
+    _executableEdges.clear();
+    _bbWorklist.clear();
+    _instWorklist.clear();
+
+    for (auto bb : function->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            _inst2bb[inst] = bb;
+        }
+    }
+
+    auto entry = function->getBasicBlocks().front();
+    _executableBBs.insert(entry);
+    _bbWorklist.push_back(entry);
+    while (!_bbWorklist.empty() || !_instWorklist.empty()) {
+        while (!_instWorklist.empty()) {
+            auto inst = _instWorklist.back();
+            _instWorklist.pop_back();
+            if (_executableBBs.find(_inst2bb[inst]) != _executableBBs.end()) {
+                visitInst(inst);
+            }
+        }
+        while (!_bbWorklist.empty()) {
+            auto bb = _bbWorklist.back();
+            _bbWorklist.pop_back();
+            for (auto inst : bb->getInstructionList()) {
+                visitInst(inst);
+            }
+        }
+    }
+
+    return rewrite();
+}
+
+SCCP::LatticeValue SCCP::getLatticeValue(Value* value) {
+    if (value->isConst()) {
+        return {LatticeValue::CONST, (Constant*)value};
+    }
+    auto iter = _lattice.find(value);
+    if (iter != _lattice.end()) {
+        return iter->second;
+    }
+    // params, globals and values of other functions are unknown
+    if (!value->getDefined() || _inst2bb.find(value->getDefined()) == _inst2bb.end()) {
+        return {LatticeValue::OVERDEFINED, nullptr};
+    }
+    return {};
+}
+
+void SCCP::setLatticeValue(Value* value, const LatticeValue& latticeValue) {
+    auto old = getLatticeValue(value);
+    if (old._state == latticeValue._state && old._constant == latticeValue._constant) {
+        return;
+    }
+    // the lattice value only goes down, from undef to const to overdefined
+    assert(old._state <= latticeValue._state && "lattice value can't go up");
+    _lattice[value] = latticeValue;
+    for (auto user : value->getUsers()) {
+        _instWorklist.push_back(user);
+    }
+}
+
+void SCCP::markOverdefined(Value* value) { setLatticeValue(value, {LatticeValue::OVERDEFINED, nullptr}); }
+
+void SCCP::markEdgeExecutable(BasicBlock* from, BasicBlock* to) {
+    if (!_executableEdges.insert({from, to}).second) {
+        return;
+    }
+    if (_executableBBs.insert(to).second) {
+        _bbWorklist.push_back(to);
+        return;
+    }
+    // the block has been visited, only the phis need to merge the value of new edge
+    for (auto inst : to->getInstructionList()) {
+        if (inst->getClassId() != ID_PHI_INST) {
+            break;
+        }
+        visitPhi((PhiInst*)inst);
+    }
+}
+
+void SCCP::visitInst(Instruction* inst) {
+    switch (inst->getClassId()) {
+        case ID_PHI_INST:
+            visitPhi((PhiInst*)inst);
+            break;
+        case ID_BINARY_INST:
+            visitBinary((BinaryInst*)inst);
+            break;
+        case ID_UNARY_INST:
+            visitUnary((UnaryInst*)inst);
+            break;
+        case ID_JUMP_INST:
+            markEdgeExecutable(_inst2bb[inst], static_cast<JumpInst*>(inst)->getTargetBB());
+            break;
+        case ID_COND_JUMP_INST:
+            visitCondJump((CondJumpInst*)inst);
+            break;
+        default:
+            // the result of call, alloc, gep and bitcast can't be known at compile time
+            if (auto result = inst->getResult()) {
+                markOverdefined(result);
+            }
+            break;
+    }
+}
+
+void SCCP::visitPhi(PhiInst* inst) {
+    auto bb = _inst2bb[inst];
+    LatticeValue merged;
+    for (auto& [value, incomingBB] : inst->getIncomings()) {
+        if (_executableEdges.find({incomingBB, bb}) == _executableEdges.end()) {
+            continue;
+        }
+        auto incoming = getLatticeValue(value);
+        if (incoming._state == LatticeValue::UNDEF) {
+            continue;
+        }
+        if (incoming._state == LatticeValue::OVERDEFINED ||
+            (merged._state == LatticeValue::CONST && merged._constant != incoming._constant)) {
+            merged = {LatticeValue::OVERDEFINED, nullptr};
+            break;
+        }
+        merged = incoming;
+    }
+    setLatticeValue(inst->getResult(), merged);
+}
+
+void SCCP::visitBinary(BinaryInst* inst) {
+    auto operand1 = getLatticeValue(inst->getOperand1());
+    auto operand2 = getLatticeValue(inst->getOperand2());
+    if (operand1._state == LatticeValue::OVERDEFINED || operand2._state == LatticeValue::OVERDEFINED) {
+        markOverdefined(inst->getResult());
+        return;
+    }
+    if (operand1._state == LatticeValue::UNDEF || operand2._state == LatticeValue::UNDEF) {
+        return;
+    }
+    if (auto folded = foldBinary(inst->getInstType(), operand1._constant, operand2._constant)) {
+        setLatticeValue(inst->getResult(), {LatticeValue::CONST, folded});
+    } else {
+        markOverdefined(inst->getResult());
+    }
+}
+
+void SCCP::visitUnary(UnaryInst* inst) {
+    if (inst->getInstType() == UnaryInst::INST_LOAD) {
+        markOverdefined(inst->getResult());
+        return;
+    }
+    auto operand = getLatticeValue(inst->getOperand());
+    if (operand._state == LatticeValue::UNDEF) {
+        return;
+    }
+    Constant* folded = nullptr;
+    if (operand._state == LatticeValue::CONST) {
+        folded = foldUnary(inst->getInstType(), operand._constant);
+    }
+    if (folded) {
+        setLatticeValue(inst->getResult(), {LatticeValue::CONST, folded});
+    } else {
+        markOverdefined(inst->getResult());
+    }
+}
+
+void SCCP::visitCondJump(CondJumpInst* inst) {
+    auto bb = _inst2bb[inst];
+    auto operand1 = getLatticeValue(inst->getOperand1());
+    auto operand2 = getLatticeValue(inst->getOperand2());
+    if (operand1._state == LatticeValue::CONST && operand2._state == LatticeValue::CONST) {
+        if (foldCondJump(inst->getInstType(), operand1._constant, operand2._constant)) {
+            markEdgeExecutable(bb, inst->getTureBB());
+        } else {
+            markEdgeExecutable(bb, inst->getFalseBB());
+        }
+        return;
+    }
+    if (operand1._state == LatticeValue::OVERDEFINED || operand2._state == LatticeValue::OVERDEFINED) {
+        markEdgeExecutable(bb, inst->getTureBB());
+        markEdgeExecutable(bb, inst->getFalseBB());
+    }
+}
+
+bool SCCP::rewrite() {
+    bool changed = false;
+    for (auto bb : _function->getBasicBlocks()) {
+        if (_executableBBs.find(bb) == _executableBBs.end()) {
+            continue;
+        }
+        auto& instList = bb->getInstructionList();
+        for (auto iter = instList.begin(); iter != instList.end();) {
+            auto inst = *iter;
+            auto result = inst->getResult();
+            if (!result || getLatticeValue(result)._state != LatticeValue::CONST) {
+                iter++;
+                continue;
+            }
+            result->replaceAllUsesWith(getLatticeValue(result)._constant);
+            inst->dropAllReferences();
+            iter = instList.erase(iter);
+            changed = true;
+        }
+
+        // only one target is reachable, replace the cond jump with jump
+        auto condJumpInst = (CondJumpInst*)instList.back();
+        if (condJumpInst->getClassId() != ID_COND_JUMP_INST) {
+            continue;
+        }
+        auto trueBB = condJumpInst->getTureBB();
+        auto falseBB = condJumpInst->getFalseBB();
+        bool trueExecutable = _executableEdges.find({bb, trueBB}) != _executableEdges.end();
+        bool falseExecutable = _executableEdges.find({bb, falseBB}) != _executableEdges.end();
+        if (trueBB != falseBB && trueExecutable == falseExecutable) {
+            continue;
+        }
+        auto targetBB = trueExecutable ? trueBB : falseBB;
+        auto deadBB = trueExecutable ? falseBB : trueBB;
+        condJumpInst->dropAllReferences();
+        instList.back() = new JumpInst(targetBB);
+        bb->removeSuccessor(deadBB);
+        deadBB->removePredecessor(bb);
+        if (targetBB == deadBB) {
+            // both targets are the same block, keep one edge
+            bb->addSuccessor(targetBB);
+            targetBB->addPredecessor(bb);
+        } else {
+            for (auto inst : deadBB->getInstructionList()) {
+                if (inst->getClassId() != ID_PHI_INST) {
+                    break;
+                }
+                static_cast<PhiInst*>(inst)->removeIncoming(bb);
+            }
+        }
+        changed = true;
+    }
+
+    // the blocks never executed are unreachable now
+    changed |= _function->removeUnreachableBB();
+    return changed;
+}
+
+Constant* SCCP::foldBinary(int type, Constant* operand1, Constant* operand2) {
+    if (operand1->isInt()) {
+        int lhs = static_cast<ConstantInt*>(operand1)->getConstValue();
+        int rhs = static_cast<ConstantInt*>(operand2)->getConstValue();
+        switch (type) {
+            case BinaryInst::INST_ADD:
+                return ConstantInt::get((unsigned)lhs + (unsigned)rhs);
+            case BinaryInst::INST_SUB:
+                return ConstantInt::get((unsigned)lhs - (unsigned)rhs);
+            case BinaryInst::INST_MUL:
+                return ConstantInt::get((unsigned)lhs * (unsigned)rhs);
+            case BinaryInst::INST_DIV:
+                if (rhs == 0 || (lhs == INT_MIN && rhs == -1)) {
+                    return nullptr;
+                }
+                return ConstantInt::get(lhs / rhs);
+            case BinaryInst::INST_MOD:
+                if (rhs == 0 || (lhs == INT_MIN && rhs == -1)) {
+                    return nullptr;
+                }
+                return ConstantInt::get(lhs % rhs);
+            case BinaryInst::INST_BIT_AND:
+                return ConstantInt::get(lhs & rhs);
+            case BinaryInst::INST_BIT_OR:
+                return ConstantInt::get(lhs | rhs);
+            case BinaryInst::INST_LT:
+                return ConstantInt::get(lhs < rhs);
+            case BinaryInst::INST_LE:
+                return ConstantInt::get(lhs <= rhs);
+            case BinaryInst::INST_GT:
+                return ConstantInt::get(lhs > rhs);
+            case BinaryInst::INST_GE:
+                return ConstantInt::get(lhs >= rhs);
+            case BinaryInst::INST_EQ:
+                return ConstantInt::get(lhs == rhs);
+            case BinaryInst::INST_NE:
+                return ConstantInt::get(lhs != rhs);
+            default:
+                return nullptr;
+        }
+    }
+
+    float lhs = static_cast<ConstantFloat*>(operand1)->getConstValue();
+    float rhs = static_cast<ConstantFloat*>(operand2)->getConstValue();
+    switch (type) {
+        case BinaryInst::INST_ADD:
+            return ConstantFloat::get(lhs + rhs);
+        case BinaryInst::INST_SUB:
+            return ConstantFloat::get(lhs - rhs);
+        case BinaryInst::INST_MUL:
+            return ConstantFloat::get(lhs * rhs);
+        case BinaryInst::INST_DIV:
+            if (rhs == 0) {
+                return nullptr;
+            }
+            return ConstantFloat::get(lhs / rhs);
+        case BinaryInst::INST_LT:
+            return ConstantInt::get(lhs < rhs);
+        case BinaryInst::INST_LE:
+            return ConstantInt::get(lhs <= rhs);
+        case BinaryInst::INST_GT:
+            return ConstantInt::get(lhs > rhs);
+        case BinaryInst::INST_GE:
+            return ConstantInt::get(lhs >= rhs);
+        case BinaryInst::INST_EQ:
+            return ConstantInt::get(lhs == rhs);
+        case BinaryInst::INST_NE:
+            return ConstantInt::get(lhs != rhs);
+        default:
+            return nullptr;
+    }
+}
+
+Constant* SCCP::foldUnary(int type, Constant* operand) {
+    switch (type) {
+        case UnaryInst::INST_ITOF:
+            return ConstantFloat::get(static_cast<ConstantInt*>(operand)->getConstValue());
+        case UnaryInst::INST_FTOI: {
+            float value = static_cast<ConstantFloat*>(operand)->getConstValue();
+            // out of range conversion is undefined, leave it to runtime
+            if (!(value > (float)INT_MIN && value < (float)INT_MAX)) {
+                return nullptr;
+            }
+            return ConstantInt::get(value);
+        }
+        default:
+            return nullptr;
+    }
+}
+
+bool SCCP::foldCondJump(int type, Constant* operand1, Constant* operand2) {
+    int binaryType;
+    switch (type) {
+        case CondJumpInst::INST_JLT:
+            binaryType = BinaryInst::INST_LT;
+            break;
+        case CondJumpInst::INST_JLE:
+            binaryType = BinaryInst::INST_LE;
+            break;
+        case CondJumpInst::INST_JGT:
+            binaryType = BinaryInst::INST_GT;
+            break;
+        case CondJumpInst::INST_JGE:
+            binaryType = BinaryInst::INST_GE;
+            break;
+        case CondJumpInst::INST_JEQ:
+            binaryType = BinaryInst::INST_EQ;
+            break;
+        case CondJumpInst::INST_JNE:
+            binaryType = BinaryInst::INST_NE;
+            break;
+        default:
+            assert(false && "should not reach here");
+            break;
+    }
+    return static_cast<ConstantInt*>(foldBinary(binaryType, operand1, operand2))->getConstValue();
+}
+
+}  // namespace IR
+}  // namespace ATC
@@ -0,0 +1,268 @@
+#include "IR/StrengthReduction.h"
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <iterator>
+#include <tuple>
+
+namespace ATC {
+namespace IR {
+
+// the constants are folded in int64, the expression is skipped if the result leaves int32
+static bool isInt32(long long value) { return value >= INT32_MIN && value <= INT32_MAX; }
+
+bool StrengthReduction::PointerKey::operator<(const PointerKey& other) const {
+    return std::tie(_ptr, _leadingIndexes, _iv, _scale, _terms) <
+           std::tie(other._ptr, other._leadingIndexes, other._iv, other._scale, other._terms);
+}
+
+bool StrengthReduction::runOnFunction(Function* function) {
+    _function = function;
+    _inst2bb.clear();
+    for (auto bb : function->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            _inst2bb[inst] = bb;
+        }
+    }
+
+    bool changed = false;
+    for (auto loop : function->getLoopInfo()->getLoopsInPostOrder()) {
+        changed |= reduceLoop(loop);
+    }
+    return changed;
+}
+
+bool StrengthReduction::reduceLoop(Loop* loop) {
+    InductionVariables ivs(loop);
+    if (ivs.getBasicIVs().empty()) {
+        return false;
+    }
+    _preheader = loop->getPreheader();
+    _pointerIVs.clear();
+    auto header = loop->getHeader();
+    auto latch = loop->getLatches().front();
+
+    std::vector<GetElementPtrInst*> geps;
+    for (auto bb : loop->getBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            if (inst->getClassId() == ID_GET_ELEMENT_PTR_INST) {
+                geps.push_back((GetElementPtrInst*)inst);
+            }
+        }
+    }
+
+    bool changed = false;
+    AffineExpression expr;
+    for (auto gep : geps) {
+        // erased as the operand of other gep
+        if (_inst2bb.find(gep) == _inst2bb.end()) {
+            continue;
+        }
+        // the step of pointer is counted by element, so the element can't be array
+        auto resultType = gep->getResult()->getType();
+        if (resultType->getBaseType()->isArrayType() || !ivs.isInvariant(gep->getPtr())) {
+            continue;
+        }
+        auto indexes = gep->getIndexes();
+        auto leadingIndexes = std::vector<Value*>(indexes.begin(), std::prev(indexes.end()));
+        bool invariant = true;
+        for (auto index : leadingIndexes) {
+            invariant &= ivs.isInvariant(index);
+        }
+        if (!invariant || !ivs.getAffine(indexes.back(), expr)) {
+            continue;
+        }
+
+        PointerKey key = {gep->getPtr(), leadingIndexes, expr._iv, expr._scale, expr._terms};
+        auto iter = _pointerIVs.find(key);
+        if (iter == _pointerIVs.end()) {
+            long long stride = (long long)expr._scale * expr._iv->_step;
+            if (!isInt32(stride) || !isInt32(foldConstant(expr, expr._iv->_init))) {
+                continue;
+            }
+            auto init = createGEPInPreheader(key, materialize(expr, expr._iv->_init));
+            auto phi = new PhiInst(resultType, gep->getResult()->getName());
+            phi->getResult()->setBelongAndInsertName(_function);
+            header->getInstructionList().push_front(phi);
+            _inst2bb[phi] = header;
+            auto next = new GetElementPtrInst(phi->getResult(), {ConstantInt::get(stride)});
+            insertBeforeTerminator(latch, next);
+            phi->addIncoming(init, _preheader);
+            phi->addIncoming(next->getResult(), latch);
+            iter = _pointerIVs.insert({key, {phi, key, expr._constant}}).first;
+        } else if (!isInt32((long long)expr._constant - iter->second._constant)) {
+            continue;
+        }
+
+        Value* pointer = iter->second._phi->getResult();
+        if (expr._constant != iter->second._constant) {
+            auto offset = ConstantInt::get(expr._constant - iter->second._constant);
+            pointer = insertBefore(gep, new GetElementPtrInst(pointer, {offset}))->getResult();
+        }
+        gep->getResult()->replaceAllUsesWith(pointer);
+        eraseDeadInst(gep);
+        changed = true;
+    }
+
+    for (auto& iv : ivs.getBasicIVs()) {
+        changed |= replaceTest(ivs, iv);
+    }
+    return changed;
+}
+
+bool StrengthReduction::replaceTest(InductionVariables& ivs, BasicInductionVariable& iv) {
+    // the pointer should increase with the induction variable to keep the result of compare
+    PointerIV* pointerIV = nullptr;
+    for (auto& [key, candidate] : _pointerIVs) {
+        if (key._iv == &iv && key._scale > 0) {
+            pointerIV = &candidate;
+            break;
+        }
+    }
+    if (!pointerIV) {
+        return false;
+    }
+
+    // the induction variable is useless after replacing if it's only used by the compares and its increment
+    for (auto user : iv._increment->getResult()->getUsers()) {
+        if (user != iv._phi) {
+            return false;
+        }
+    }
+    std::vector<CondJumpInst*> compares;
+    for (auto user : iv._phi->getResult()->getUsers()) {
+        if (user == iv._increment) {
+            continue;
+        }
+        if (user->getClassId() != ID_COND_JUMP_INST || !ivs.getLoop()->contains(_inst2bb[user]) ||
+            (!ivs.isInvariant(user->getOperand(0)) && !ivs.isInvariant(user->getOperand(1)))) {
+            return false;
+        }
+        compares.push_back((CondJumpInst*)user);
+    }
+    if (compares.empty()) {
+        return false;
+    }
+
+    auto& key = pointerIV->_key;
+    AffineExpression expr;
+    expr._iv = key._iv;
+    expr._scale = key._scale;
+    expr._terms = key._terms;
+    expr._constant = pointerIV->_constant;
+    for (auto compare : compares) {
+        int ivIndex = compare->getOperand(0) == iv._phi->getResult() ? 0 : 1;
+        if (!isLimitInRange(expr, compare->getOperand(1 - ivIndex))) {
+            return false;
+        }
+    }
+    for (auto compare : compares) {
+        int ivIndex = compare->getOperand(0) == iv._phi->getResult() ? 0 : 1;
+        auto limit = compare->getOperand(1 - ivIndex);
+        compare->setOperand(ivIndex, pointerIV->_phi->getResult());
+        compare->setOperand(1 - ivIndex, createGEPInPreheader(key, materialize(expr, limit)));
+    }
+    return true;
+}
+
+bool StrengthReduction::isLimitInRange(const AffineExpression& expr, Value* limit) {
+    for (auto [value, coefficient] : expr._terms) {
+        if (coefficient != 0 && !value->isConst()) {
+            return false;
+        }
+    }
+    long long constant = foldConstant(expr, limit);
+    if (limit->isConst()) {
+        return isInt32(constant);
+    }
+    // the limit itself is in range, anything added to it may overflow
+    return expr._scale == 1 && constant == 0;
+}
+
+long long StrengthReduction::foldConstant(const AffineExpression& expr, Value* ivValue) {
+    auto terms = expr._terms;
+    terms.push_back({ivValue, expr._scale});
+    long long constant = expr._constant;
+    for (auto [value, coefficient] : terms) {
+        if (value->isConst()) {
+            constant += (long long)coefficient * static_cast<ConstantInt*>(value)->getConstValue();
+        }
+    }
+    return constant;
+}
+
+Value* StrengthReduction::materialize(const AffineExpression& expr, Value* ivValue) {
+    auto terms = expr._terms;
+    terms.push_back({ivValue, expr._scale});
+    long long constant = foldConstant(expr, ivValue);
+    assert(isInt32(constant) && "the folded constant should be in int32");
+    Value* result = nullptr;
+    for (auto [value, coefficient] : terms) {
+        if (coefficient == 0 || value->isConst()) {
+            continue;
+        }
+        if (coefficient != 1) {
+            auto mul = new BinaryInst(BinaryInst::INST_MUL, value, ConstantInt::get(coefficient));
+            value = insertBeforeTerminator(_preheader, mul)->getResult();
+        }
+        if (result) {
+            auto add = new BinaryInst(BinaryInst::INST_ADD, result, value);
+            value = insertBeforeTerminator(_preheader, add)->getResult();
+        }
+        result = value;
+    }
+    if (!result) {
+        return ConstantInt::get(constant);
+    }
+    if (constant != 0) {
+        auto add = new BinaryInst(BinaryInst::INST_ADD, result, ConstantInt::get(constant));
+        result = insertBeforeTerminator(_preheader, add)->getResult();
+    }
+    return result;
+}
+
+Value* StrengthReduction::createGEPInPreheader(const PointerKey& key, Value* index) {
+    auto indexes = key._leadingIndexes;
+    indexes.push_back(index);
+    return insertBeforeTerminator(_preheader, new GetElementPtrInst(key._ptr, indexes))->getResult();
+}
+
+Instruction* StrengthReduction::insertBeforeTerminator(BasicBlock* bb, Instruction* inst) {
+    if (inst->getResult()) {
+        inst->getResult()->setBelongAndInsertName(_function);
+    }
+    auto& instList = bb->getInstructionList();
+    assert(!instList.empty() && "the block should have terminator");
+    instList.insert(std::prev(instList.end()), inst);
+    _inst2bb[inst] = bb;
+    return inst;
+}
+
+Instruction* StrengthReduction::insertBefore(Instruction* pos, Instruction* inst) {
+    inst->getResult()->setBelongAndInsertName(_function);
+    auto bb = _inst2bb[pos];
+    auto& instList = bb->getInstructionList();
+    instList.insert(std::find(instList.begin(), instList.end(), pos), inst);
+    _inst2bb[inst] = bb;
+    return inst;
+}
+
+void StrengthReduction::eraseDeadInst(Instruction* inst) {
+    // the index computation of replaced gep is dead, erase it so the induction variable may become useless
+    auto operands = inst->getOperands();
+    inst->dropAllReferences();
+    auto& instList = _inst2bb[inst]->getInstructionList();
+    instList.erase(std::find(instList.begin(), instList.end(), inst));
+    _inst2bb.erase(inst);
+    for (auto operand : operands) {
+        auto defined = operand->getDefined();
+        if (defined && !operand->hasUses() && _inst2bb.find(defined) != _inst2bb.end() &&
+            (defined->getClassId() == ID_BINARY_INST || defined->getClassId() == ID_GET_ELEMENT_PTR_INST)) {
+            eraseDeadInst(defined);
+        }
+    }
+}
+
+}  // namespace IR
+}  // namespace ATC
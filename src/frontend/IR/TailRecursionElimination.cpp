@@ -0,0 +1,185 @@
+#include "IR/TailRecursionElimination.h"
+
+#include <iterator>
+#include <set>
+
+namespace ATC {
+namespace IR {
+
+bool TailRecursionElimination::runOnFunction(Function* function) {
+    _function = function;
+    auto entryBB = function->getBasicBlocks().front();
+    auto terminator = entryBB->getInstructionList().back();
+    if (terminator->getClassId() != ID_JUMP_INST) {
+        return false;
+    }
+    auto beginBB = static_cast<JumpInst*>(terminator)->getTargetBB();
+    if (beginBB->getPredecessors().size() != 1) {
+        return false;
+    }
+
+    std::vector<TailCall> tailCalls;
+    int accumulateType = -1;
+    for (auto bb : function->getBasicBlocks()) {
+        TailCall tailCall;
+        if (!findTailCall(bb, tailCall)) {
+            continue;
+        }
+        if (tailCall._accumulate) {
+            if (accumulateType == -1) {
+                accumulateType = tailCall._accumulate->getInstType();
+            } else if (tailCall._accumulate->getInstType() != accumulateType) {
+                continue;
+            }
+        }
+        tailCalls.push_back(tailCall);
+    }
+    if (tailCalls.empty()) {
+        return false;
+    }
+    eliminate(tailCalls, beginBB, accumulateType);
+
+    bool hasCall = false;
+    for (auto bb : function->getBasicBlocks()) {
+        for (auto inst : bb->getInstructionList()) {
+            hasCall |= inst->getClassId() == ID_FUNCTION_CALL_INST;
+        }
+    }
+    function->setHasFunctionCall(hasCall);
+    return true;
+}
+
+bool TailRecursionElimination::findTailCall(BasicBlock* bb, TailCall& tailCall) {
+    auto& instList = bb->getInstructionList();
+    if (instList.size() < 2 || instList.back()->getClassId() != ID_RETURN_INST) {
+        return false;
+    }
+    auto retValue = static_cast<ReturnInst*>(instList.back())->getRetValue();
+    auto prev = *std::prev(instList.end(), 2);
+    tailCall._bb = bb;
+    tailCall._accumulate = nullptr;
+    tailCall._operand = nullptr;
+    if (prev->getClassId() == ID_BINARY_INST && instList.size() >= 3) {
+        // return x + f(...) or return x * f(...)
+        auto binaryInst = (BinaryInst*)prev;
+        auto call = *std::prev(instList.end(), 3);
+        if (binaryInst->getResult() != retValue || call->getClassId() != ID_FUNCTION_CALL_INST ||
+            !binaryInst->isIntInst() ||
+            (binaryInst->getInstType() != BinaryInst::INST_ADD && binaryInst->getInstType() != BinaryInst::INST_MUL)) {
+            return false;
+        }
+        auto callResult = call->getResult();
+        if (!callResult || callResult->getUsers().size() != 1 ||
+            binaryInst->getOperand1() == binaryInst->getOperand2()) {
+            return false;
+        }
+        if (binaryInst->getOperand1() == callResult) {
+            tailCall._operand = binaryInst->getOperand2();
+        } else if (binaryInst->getOperand2() == callResult) {
+            tailCall._operand = binaryInst->getOperand1();
+        } else {
+            return false;
+        }
+        tailCall._accumulate = binaryInst;
+        prev = call;
+    } else if (prev->getClassId() != ID_FUNCTION_CALL_INST || prev->getResult() != retValue) {
+        return false;
+    }
+
+    auto call = (FunctionCallInst*)prev;
+    if (call->getFuncName() != _function->getName()) {
+        return false;
+    }
+    // the local memory of this call is reused by the next iteration
+    for (auto arg : call->getParams()) {
+        if (arg->getType()->isPointerType() && getBaseAddr(arg)->getDefined() &&
+            getBaseAddr(arg)->getDefined()->getClassId() == ID_ALLOC_INST) {
+            return false;
+        }
+    }
+    tailCall._call = call;
+    return true;
+}
+
+void TailRecursionElimination::eliminate(const std::vector<TailCall>& tailCalls, BasicBlock* beginBB,
+                                         int accumulateType) {
+    auto entryBB = _function->getBasicBlocks().front();
+    std::set<Instruction*> entryInsts(entryBB->getInstructionList().begin(), entryBB->getInstructionList().end());
+
+    // the params are replaced by phis except in the entry, which is not in the loop
+    std::vector<PhiInst*> paramPhis;
+    for (auto param : _function->getParams()) {
+        auto phi = new PhiInst(param->getType());
+        phi->getResult()->setBelongAndInsertName(_function);
+        for (auto use : param->getUses()) {
+            if (entryInsts.find(use->getUser()) == entryInsts.end()) {
+                use->set(phi->getResult());
+            }
+        }
+        phi->addIncoming(param, entryBB);
+        paramPhis.push_back(phi);
+    }
+    auto& beginInstList = beginBB->getInstructionList();
+    beginInstList.insert(beginInstList.begin(), paramPhis.begin(), paramPhis.end());
+
+    PhiInst* accumulator = nullptr;
+    std::set<BasicBlock*> tailCallBBs;
+    for (auto& tailCall : tailCalls) {
+        tailCallBBs.insert(tailCall._bb);
+    }
+    if (accumulateType != -1) {
+        accumulator = new PhiInst(Type::getInt32Ty(), "accumulator");
+        accumulator->getResult()->setBelongAndInsertName(_function);
+        accumulator->addIncoming(ConstantInt::get(accumulateType == BinaryInst::INST_ADD ? 0 : 1), entryBB);
+        beginInstList.push_front(accumulator);
+
+        // the other returns apply the accumulator to their values
+        for (auto bb : _function->getBasicBlocks()) {
+            auto& instList = bb->getInstructionList();
+            if (tailCallBBs.find(bb) != tailCallBBs.end() || instList.back()->getClassId() != ID_RETURN_INST) {
+                continue;
+            }
+            auto ret = (ReturnInst*)instList.back();
+            auto result = new BinaryInst(accumulateType, accumulator->getResult(), ret->getRetValue());
+            result->getResult()->setBelongAndInsertName(_function);
+            instList.insert(std::prev(instList.end()), result);
+            ret->setOperand(0, result->getResult());
+        }
+    }
+
+    for (auto& tailCall : tailCalls) {
+        auto bb = tailCall._bb;
+        auto args = tailCall._call->getParams();
+        for (size_t i = 0; i < args.size(); i++) {
+            paramPhis[i]->addIncoming(args[i], bb);
+        }
+
+        auto& instList = bb->getInstructionList();
+        auto ret = instList.back();
+        ret->dropAllReferences();
+        instList.pop_back();
+        if (tailCall._accumulate) {
+            tailCall._accumulate->dropAllReferences();
+            instList.pop_back();
+        }
+        tailCall._call->dropAllReferences();
+        instList.pop_back();
+
+        if (accumulator) {
+            Value* next = accumulator->getResult();
+            if (tailCall._accumulate) {
+                auto accumulate = new BinaryInst(accumulateType, accumulator->getResult(), tailCall._operand);
+                accumulate->getResult()->setBelongAndInsertName(_function);
+                instList.push_back(accumulate);
+                next = accumulate->getResult();
+            }
+            accumulator->addIncoming(next, bb);
+        }
+        instList.push_back(new JumpInst(beginBB));
+        bb->addSuccessor(beginBB);
+        beginBB->addPredecessor(bb);
+    }
+}
+
+}  // namespace IR
+}  // namespace ATC
@@ -7,11 +7,74 @@
 namespace ATC {
 namespace IR {
 
+Use::Use(Value* value, Instruction* user) : _value(value), _user(user) { addToList(); }
+
+void Use::set(Value* value) {
+    removeFromList();
+    _value = value;
+    addToList();
+}
+
+void Use::addToList() {
+    if (!_value) {
+        return;
+    }
+    _next = _value->_useList;
+    if (_next) {
+        _next->_prev = &_next;
+    }
+    _prev = &_value->_useList;
+    _value->_useList = this;
+}
+
+void Use::removeFromList() {
+    if (!_prev) {
+        return;
+    }
+    *_prev = _next;
+    if (_next) {
+        _next->_prev = _prev;
+    }
+    _next = nullptr;
+    _prev = nullptr;
+}
+
+std::vector<Use*> Value::getUses() {
+    std::vector<Use*> uses;
+    for (Use* use = _useList; use; use = use->getNext()) {
+        uses.push_back(use);
+    }
+    return uses;
+}
+
+std::vector<Instruction*> Value::getUsers() {
+    std::vector<Instruction*> users;
+    for (Use* use = _useList; use; use = use->getNext()) {
+        users.push_back(use->getUser());
+    }
+    return users;
+}
+
+void Value::replaceAllUsesWith(Value* value) {
+    assert(value != this && "can't replace a value with itself");
+    while (_useList) {
+        _useList->set(value);
+    }
+}
+
 void Value::setBelongAndInsertName(Function* function) {
     _belong = function;
     _belong->insertName(this);
 }
 
+std::vector<Constant*> Constant::AllConstants;
+
+void Constant::clearUseLists() {
+    for (auto constant : AllConstants) {
+        constant->_useList = nullptr;
+    }
+}
+
 ConstantInt* ConstantInt::get(int value) {
     static std::unordered_map<int, ConstantInt*> num2Value;
     if (num2Value.find(value) != num2Value.end()) {
@@ -19,6 +82,7 @@ ConstantInt* ConstantInt::get(int value) {
     }
     ConstantInt* ret = new ConstantInt(value);
     num2Value.insert({value, ret});
+    AllConstants.push_back(ret);
     return ret;
 }
 
@@ -29,6 +93,7 @@ ConstantFloat* ConstantFloat::get(float value) {
     }
     ConstantFloat* ret = new ConstantFloat(value);
     num2Value.insert({value, ret});
+    AllConstants.push_back(ret);
     return ret;
 }
 
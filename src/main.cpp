@@ -1,5 +1,6 @@
 #include <stdio.h>
 
+#include <chrono>
 #include <filesystem>
 #include <iostream>
 #include <string>
@@ -11,17 +12,21 @@
 #include "AST/SemanticChecker.h"
 #include "ATCLexer.h"
 #include "ATCParser.h"
+#include "Arena.h"
 #include "CmdOption.h"
 #include "IR/IRBuilder.h"
+#include "IR/PassManager.h"
 #include "antlr4-runtime.h"
 #include "arm/CodeGenerator.h"
 #include "riscv/CodeGenerator.h"
+#include "riscv/PeepholeOptimizer.h"
 
 using namespace std;
 using namespace antlr4;
 using namespace ATC;
 
 int main(int argc, const char *argv[]) {
+    initSharedOptions();
     llvm::cl::HideUnrelatedOptions({&MyCategory});
     llvm::cl::ParseCommandLineOptions(argc, argv);
 
@@ -34,6 +39,14 @@ int main(int argc, const char *argv[]) {
             return -1;
         }
 
+        // the ast and ir of a compilation unit are released together at the end of the iteration
+        Arena astArena;
+        Arena irArena;
+        // the constants outlive the unit, but their use lists link the uses in irArena
+        irArena.addDestructor(nullptr, [](void *) { IR::Constant::clearUseLists(); });
+        ArenaScope astScope(AST_ARENA, &astArena);
+        ArenaScope irScope(IR_ARENA, &irArena);
+
         ANTLRInputStream input(file);
         ATCLexer lexer(&input);
         CommonTokenStream token(&lexer);
@@ -60,13 +73,31 @@ int main(int argc, const char *argv[]) {
         std::filesystem::path filePath = SrcPath;
         string filename = filePath.stem();
 
+        IR::PassManager passManager;
+        auto start = chrono::steady_clock::now();
         IR::IRBuilder irBuilder;
         compUnit->accept(&irBuilder);
+        chrono::duration<double> duration = chrono::steady_clock::now() - start;
+        passManager.addTime("IRBuilder", duration.count());
+
+        passManager.buildPipeline(OptLevel);
+        irBuilder.getCurrentModule()->setIsWholeProgram(SrcPathList.size() == 1);
+        passManager.run(irBuilder.getCurrentModule());
         if (DumpIR) {
             irBuilder.dumpIR(filename + ".atom");
         }
+
+        start = chrono::steady_clock::now();
         RISCV::CodeGenerator codeGenerator;
         codeGenerator.emitModule(irBuilder.getCurrentModule());
+        duration = chrono::steady_clock::now() - start;
+        passManager.addTime("RISCV::CodeGenerator", duration.count());
+        if (TimePasses) {
+            passManager.printTimeReport();
+        }
+        if (PeepholeStats) {
+            RISCV::PeepholeOptimizer::printStatistics(std::cerr);
+        }
 
         ofstream asmfile(filename + ".s", ios::trunc);
         codeGenerator.print(asmfile);